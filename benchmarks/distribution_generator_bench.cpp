@@ -0,0 +1,84 @@
+// Compares point generation with a loop over next against bulk generation
+// with fill for every kind of generator, and the fast paths of the spaced
+// generators against their exact paths for large ranges
+// Build: g++ -O3 -std=c++11 benchmarks/distribution_generator_bench.cpp
+// (add -Ofast -march=native to let the exponential loops use libmvec)
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "../src/distribution_generator.hpp"
+
+// Returns the time per point (in ns) to generate count points with next
+double time_next ( Generators kind, uint_fast64_t count, uint_fast64_t *points ) {
+    DistributionGenerator *generator = DistributionGenerator::make_generator(4096, 1ul << 32, kind, count);
+    auto begin = chrono::steady_clock::now();
+    uint_fast64_t i = 0;
+    while ( ! generator->is_done() ) points[i++] = generator->next();
+    auto finish = chrono::steady_clock::now();
+    delete generator;
+    return chrono::duration<double, nano>(finish - begin).count() / count;
+}
+
+// Returns the time per point (in ns) to generate count points with fill
+double time_fill ( Generators kind, uint_fast64_t count, uint_fast64_t *points ) {
+    DistributionGenerator *generator = DistributionGenerator::make_generator(4096, 1ul << 32, kind, count);
+    auto begin = chrono::steady_clock::now();
+    generator->fill(points, count);
+    auto finish = chrono::steady_clock::now();
+    delete generator;
+    return chrono::duration<double, nano>(finish - begin).count() / count;
+}
+
+// Returns the time per point (in ns) to fill count points with a generator
+double time_generator ( DistributionGenerator *generator, uint_fast64_t count,
+        uint_fast64_t *points ) {
+    auto begin = chrono::steady_clock::now();
+    generator->fill(points, count);
+    auto finish = chrono::steady_clock::now();
+    delete generator;
+    return chrono::duration<double, nano>(finish - begin).count() / count;
+}
+
+int main () {
+    const uint_fast64_t count = 1ul << 20;
+    const Generators kinds[] = { UNIFORMLY_SPACED, EXPONENTIALLY_SPACED,
+        UNIFORMLY_RANDOM, EXPONENTIALLY_RANDOM };
+    const string names[] = { "uniformly_spaced", "exponentially_spaced",
+        "uniformly_random", "exponentially_random" };
+    vector<uint_fast64_t> points(count);
+
+    cout << "generator,points,next_ns_per_point,fill_ns_per_point" << endl;
+    for ( int k = 0; k < 4; ++k ) {
+        double looped = time_next(kinds[k], count, points.data());
+        double filled = time_fill(kinds[k], count, points.data());
+        cout << names[k] << "," << count << "," << looped << "," << filled << endl;
+    }
+
+    // Random generators on the random device (previous behavior) and on the
+    // default engine
+    cout << endl << "generator,points,device_ns_per_point,xoshiro_ns_per_point" << endl;
+    double device = time_generator(new UniformlyRandom<DeviceEngine>(4096, 1ul << 32, count), count, points.data());
+    double xoshiro = time_generator(new UniformlyRandom<>(4096, 1ul << 32, count), count, points.data());
+    cout << names[2] << "," << count << "," << device << "," << xoshiro << endl;
+    device = time_generator(new ExponentiallyRandom<DeviceEngine>(4096, 1ul << 32, count), count, points.data());
+    xoshiro = time_generator(new ExponentiallyRandom<>(4096, 1ul << 32, count), count, points.data());
+    cout << names[3] << "," << count << "," << device << "," << xoshiro << endl;
+
+    // Spaced generators up to 2^32 (64-bit products and double precision)
+    // and up to 2^63 (128-bit products and long double precision), with and
+    // without alignment to pages
+    cout << endl << "generator,points,fast_ns_per_point,exact_ns_per_point,"
+        "aligned_ns_per_point" << endl;
+    for ( int k = 0; k < 2; ++k ) {
+        double fast = time_generator(DistributionGenerator::make_generator(
+                    4096, 1ul << 32, kinds[k], count), count, points.data());
+        double exact = time_generator(DistributionGenerator::make_generator(
+                    4096, 1ul << 63, kinds[k], count), count, points.data());
+        double aligned = time_generator(DistributionGenerator::make_generator(
+                    4096, 1ul << 32, kinds[k], count, 0, 4096), count, points.data());
+        cout << names[k] << "," << count << "," << fast << "," << exact << ","
+            << aligned << endl;
+    }
+}
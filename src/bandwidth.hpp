@@ -0,0 +1,734 @@
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define TOPOPERF_X86 1
+#endif
+
+#include "buffer_arena.hpp"
+#include "distribution_generator.hpp"
+#include "threading.hpp"
+
+using namespace std;
+
+// Classes in this file
+class BandwidthEngine;
+
+// Streaming kernels measured by the bandwidth engine
+enum BandwidthKernel {
+    READ,       // sum += a[i]
+    WRITE,      // a[i] = s
+    COPY,       // a[i] = b[i]
+    TRIAD,      // a[i] = b[i] + s * c[i]
+    RMW,        // a[i] += s (read-modify-write)
+    STREAM_WRITE,   // a[i] = s with non-temporal stores
+    STREAM_COPY     // a[i] = b[i] with non-temporal stores
+};
+
+// Instructions that write back cache lines to memory
+enum FlushInstruction {
+    CLFLUSH,        // Writes back and invalidates, ordered with other flushes
+    CLFLUSHOPT,     // Writes back and invalidates, weakly ordered
+    CLWB            // Writes back, the line may stay in the cache
+};
+
+// Instruction sets available for the kernels
+enum VectorIsa {
+    SCALAR,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+// Set of kernels compiled for one instruction set
+// n is the number of doubles and must be a multiple of KERNEL_BLOCK
+struct BandwidthKernels {
+    VectorIsa isa;
+    double (*read) ( const double *a, uint_fast64_t n );
+    void (*write) ( double *a, double s, uint_fast64_t n );
+    void (*copy) ( double *a, const double *b, uint_fast64_t n );
+    void (*triad) ( double *a, const double *b, const double *c, double s,
+            uint_fast64_t n );
+    void (*rmw) ( double *a, double s, uint_fast64_t n );
+    void (*stream_write) ( double *a, double s, uint_fast64_t n );
+    void (*stream_copy) ( double *a, const double *b, uint_fast64_t n );
+};
+
+// Bandwidth measured for one buffer size and kernel
+struct BandwidthPoint {
+    uint_fast64_t size;     //Bytes of each array per thread
+    BandwidthKernel kernel; //Kernel that was measured
+    unsigned threads;       //Number of threads running the kernel
+    double gb_per_s;        //Aggregated bandwidth of all threads (10^9 B/s)
+    uint_fast64_t page_size;    //Size of the pages backing the arrays
+};
+
+// Cost of writing back the cache lines of a buffer
+struct FlushPoint {
+    uint_fast64_t size;     //Bytes of dirty lines flushed
+    FlushInstruction instruction;
+    double ns_per_line;     //Average time of one flush, including the fence
+    double gb_per_s;        //Bytes of lines written back (10^9 B/s)
+};
+
+// Number of doubles processed by one iteration of every kernel (256 bytes)
+const uint_fast64_t KERNEL_BLOCK = 32ul;
+
+// Returns the best instruction set supported by the running CPU
+VectorIsa best_vector_isa (  );
+// Returns the kernels for an instruction set
+BandwidthKernels kernels_for ( VectorIsa isa );
+// Returns the name of a kernel
+string kernel_name ( BandwidthKernel kernel );
+// Returns the number of bytes moved by one pass of a kernel over n doubles
+uint_fast64_t kernel_bytes ( BandwidthKernel kernel, uint_fast64_t n );
+// Returns true if the running CPU has a flush instruction
+bool flush_supported ( FlushInstruction instruction );
+// Returns the name of a flush instruction
+string flush_name ( FlushInstruction instruction );
+
+/****************************************************************************/
+// Engine that measures sustained bandwidth of streaming kernels with several
+// pinned threads. Each thread works on its own arrays, which are allocated
+// once at the largest size and first touched by the thread that uses them.
+// The size of a measurement is the size of each array of one thread, so a
+// size fitting in the L2 cache measures L2 bandwidth on every core at once.
+// STREAM_WRITE and STREAM_COPY use non-temporal stores, which skip the read
+// for ownership of WRITE and COPY; comparing them shows its cost. The engine
+// also measures the cost of writing back dirty lines with the flush
+// instructions (measure_flush and flush_sweep).
+// Example of use:
+//   DistributionGenerator *generator = DistributionGenerator::make_generator(
+//       4096, 1ul<<32, EXPONENTIALLY_SPACED, 40);
+//   BandwidthEngine engine(8);
+//   for ( BandwidthPoint &point : engine.sweep(generator, {READ, TRIAD}) )
+//       std::cout << point.size << " " << point.gb_per_s << std::endl;
+class BandwidthEngine {
+    private:
+        unsigned threads_;              //Number of threads
+        vector<int> cpus_;              //CPU of each thread
+        uint_fast64_t traffic_;         //Minimum bytes moved per thread
+        BandwidthKernels kernels_;      //Kernels for the selected ISA
+        uint_fast64_t capacity_ = 0;    //Doubles in each array
+        vector<double*> arrays_;        //Three arrays per thread (a, b, c)
+        bool owned_ = true;             //False if the arrays are an arena's
+        uint_fast64_t page_size_;       //Size of the pages of the arrays
+
+        //Runs repetitions of a kernel over n doubles of a thread's arrays
+        double run ( BandwidthKernel kernel, unsigned thread, uint_fast64_t n,
+                uint_fast64_t repetitions );
+        //Releases all arrays
+        void release (  );
+
+    public:
+        //Constructor with the number of threads, the CPUs they are pinned
+        //to (round robin over the allowed CPUs if empty), the minimum number
+        //of bytes moved per thread in each measurement, and the ISA to use
+        BandwidthEngine ( unsigned threads = thread::hardware_concurrency(),
+                vector<int> cpus = vector<int>(),
+                uint_fast64_t traffic = 1ul << 28,
+                VectorIsa isa = best_vector_isa() );
+        ~BandwidthEngine (  ) { release(); }
+        BandwidthEngine ( const BandwidthEngine & ) = delete;
+        BandwidthEngine &operator= ( const BandwidthEngine & ) = delete;
+
+        //Splits an arena in the arrays of all threads instead of allocating.
+        //The arena must outlive the engine and is not first touched again
+        void attach ( BufferArena &arena );
+        //Allocates and first-touches arrays of size bytes for every thread
+        void reserve ( uint_fast64_t size );
+        //Measures one kernel with arrays of size bytes per thread (in GB/s)
+        double measure ( BandwidthKernel kernel, uint_fast64_t size );
+        //Measures every size provided by the generator for each kernel
+        vector<BandwidthPoint> sweep ( DistributionGenerator *generator,
+                const vector<BandwidthKernel> &kernels =
+                    { READ, WRITE, COPY, TRIAD } );
+        //Measures every size of a list for each kernel
+        vector<BandwidthPoint> sweep ( const vector<uint_fast64_t> &sizes,
+                const vector<BandwidthKernel> &kernels =
+                    { READ, WRITE, COPY, TRIAD } );
+        //Measures the time to flush size bytes of dirty lines with one
+        //thread (in ns per line). Returns 0 if the CPU lacks the instruction
+        double measure_flush ( FlushInstruction instruction, uint_fast64_t size );
+        //Measures every size provided by the generator for each supported
+        //flush instruction
+        vector<FlushPoint> flush_sweep ( DistributionGenerator *generator,
+                const vector<FlushInstruction> &instructions =
+                    { CLFLUSH, CLFLUSHOPT, CLWB } );
+        //Instruction set used by the kernels
+        VectorIsa isa (  ) const { return kernels_.isa; }
+        //Number of threads
+        unsigned threads (  ) const { return threads_; }
+};
+
+/****************************************************************************/
+// Kernel implementations
+// Every kernel processes KERNEL_BLOCK doubles per iteration with independent
+// accumulators, so the loop is limited by memory and not by dependencies.
+
+double read_scalar ( const double *a, uint_fast64_t n ) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    for ( uint_fast64_t i = 0; i < n; i += 4 ) {
+        s0 += a[i]; s1 += a[i+1]; s2 += a[i+2]; s3 += a[i+3];
+    }
+    return s0 + s1 + s2 + s3;
+}
+
+void write_scalar ( double *a, double s, uint_fast64_t n ) {
+    for ( uint_fast64_t i = 0; i < n; ++i ) a[i] = s;
+}
+
+void copy_scalar ( double *a, const double *b, uint_fast64_t n ) {
+    for ( uint_fast64_t i = 0; i < n; ++i ) a[i] = b[i];
+}
+
+void triad_scalar ( double *a, const double *b, const double *c, double s,
+        uint_fast64_t n ) {
+    for ( uint_fast64_t i = 0; i < n; ++i ) a[i] = b[i] + s * c[i];
+}
+
+void rmw_scalar ( double *a, double s, uint_fast64_t n ) {
+    for ( uint_fast64_t i = 0; i < n; ++i ) a[i] += s;
+}
+
+// Without vector instructions, non-temporal kernels use regular stores
+void stream_write_scalar ( double *a, double s, uint_fast64_t n ) {
+    write_scalar(a, s, n);
+}
+
+void stream_copy_scalar ( double *a, const double *b, uint_fast64_t n ) {
+    copy_scalar(a, b, n);
+}
+
+#ifdef TOPOPERF_X86
+
+__attribute__((target("sse2")))
+double read_sse2 ( const double *a, uint_fast64_t n ) {
+    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+    __m128d s2 = _mm_setzero_pd(), s3 = _mm_setzero_pd();
+    for ( uint_fast64_t i = 0; i < n; i += 8 ) {
+        s0 = _mm_add_pd(s0, _mm_load_pd(a + i));
+        s1 = _mm_add_pd(s1, _mm_load_pd(a + i + 2));
+        s2 = _mm_add_pd(s2, _mm_load_pd(a + i + 4));
+        s3 = _mm_add_pd(s3, _mm_load_pd(a + i + 6));
+    }
+    double out[2];
+    _mm_storeu_pd(out, _mm_add_pd(_mm_add_pd(s0, s1), _mm_add_pd(s2, s3)));
+    return out[0] + out[1];
+}
+
+__attribute__((target("sse2")))
+void write_sse2 ( double *a, double s, uint_fast64_t n ) {
+    __m128d v = _mm_set1_pd(s);
+    for ( uint_fast64_t i = 0; i < n; i += 8 ) {
+        _mm_store_pd(a + i, v);     _mm_store_pd(a + i + 2, v);
+        _mm_store_pd(a + i + 4, v); _mm_store_pd(a + i + 6, v);
+    }
+}
+
+__attribute__((target("sse2")))
+void copy_sse2 ( double *a, const double *b, uint_fast64_t n ) {
+    for ( uint_fast64_t i = 0; i < n; i += 8 ) {
+        _mm_store_pd(a + i, _mm_load_pd(b + i));
+        _mm_store_pd(a + i + 2, _mm_load_pd(b + i + 2));
+        _mm_store_pd(a + i + 4, _mm_load_pd(b + i + 4));
+        _mm_store_pd(a + i + 6, _mm_load_pd(b + i + 6));
+    }
+}
+
+__attribute__((target("sse2")))
+void triad_sse2 ( double *a, const double *b, const double *c, double s,
+        uint_fast64_t n ) {
+    __m128d v = _mm_set1_pd(s);
+    for ( uint_fast64_t i = 0; i < n; i += 4 ) {
+        _mm_store_pd(a + i, _mm_add_pd(_mm_load_pd(b + i),
+                    _mm_mul_pd(v, _mm_load_pd(c + i))));
+        _mm_store_pd(a + i + 2, _mm_add_pd(_mm_load_pd(b + i + 2),
+                    _mm_mul_pd(v, _mm_load_pd(c + i + 2))));
+    }
+}
+
+__attribute__((target("sse2")))
+void rmw_sse2 ( double *a, double s, uint_fast64_t n ) {
+    __m128d v = _mm_set1_pd(s);
+    for ( uint_fast64_t i = 0; i < n; i += 4 ) {
+        _mm_store_pd(a + i, _mm_add_pd(_mm_load_pd(a + i), v));
+        _mm_store_pd(a + i + 2, _mm_add_pd(_mm_load_pd(a + i + 2), v));
+    }
+}
+
+// Non-temporal stores are weakly ordered, so kernels using them end with a
+// store fence
+__attribute__((target("sse2")))
+void stream_write_sse2 ( double *a, double s, uint_fast64_t n ) {
+    __m128d v = _mm_set1_pd(s);
+    for ( uint_fast64_t i = 0; i < n; i += 8 ) {
+        _mm_stream_pd(a + i, v);     _mm_stream_pd(a + i + 2, v);
+        _mm_stream_pd(a + i + 4, v); _mm_stream_pd(a + i + 6, v);
+    }
+    _mm_sfence();
+}
+
+__attribute__((target("sse2")))
+void stream_copy_sse2 ( double *a, const double *b, uint_fast64_t n ) {
+    for ( uint_fast64_t i = 0; i < n; i += 8 ) {
+        _mm_stream_pd(a + i, _mm_load_pd(b + i));
+        _mm_stream_pd(a + i + 2, _mm_load_pd(b + i + 2));
+        _mm_stream_pd(a + i + 4, _mm_load_pd(b + i + 4));
+        _mm_stream_pd(a + i + 6, _mm_load_pd(b + i + 6));
+    }
+    _mm_sfence();
+}
+
+__attribute__((target("avx2")))
+double read_avx2 ( const double *a, uint_fast64_t n ) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+    for ( uint_fast64_t i = 0; i < n; i += 16 ) {
+        s0 = _mm256_add_pd(s0, _mm256_load_pd(a + i));
+        s1 = _mm256_add_pd(s1, _mm256_load_pd(a + i + 4));
+        s2 = _mm256_add_pd(s2, _mm256_load_pd(a + i + 8));
+        s3 = _mm256_add_pd(s3, _mm256_load_pd(a + i + 12));
+    }
+    double out[4];
+    _mm256_storeu_pd(out, _mm256_add_pd(_mm256_add_pd(s0, s1),
+                _mm256_add_pd(s2, s3)));
+    return out[0] + out[1] + out[2] + out[3];
+}
+
+__attribute__((target("avx2")))
+void write_avx2 ( double *a, double s, uint_fast64_t n ) {
+    __m256d v = _mm256_set1_pd(s);
+    for ( uint_fast64_t i = 0; i < n; i += 16 ) {
+        _mm256_store_pd(a + i, v);     _mm256_store_pd(a + i + 4, v);
+        _mm256_store_pd(a + i + 8, v); _mm256_store_pd(a + i + 12, v);
+    }
+}
+
+__attribute__((target("avx2")))
+void copy_avx2 ( double *a, const double *b, uint_fast64_t n ) {
+    for ( uint_fast64_t i = 0; i < n; i += 16 ) {
+        _mm256_store_pd(a + i, _mm256_load_pd(b + i));
+        _mm256_store_pd(a + i + 4, _mm256_load_pd(b + i + 4));
+        _mm256_store_pd(a + i + 8, _mm256_load_pd(b + i + 8));
+        _mm256_store_pd(a + i + 12, _mm256_load_pd(b + i + 12));
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void triad_avx2 ( double *a, const double *b, const double *c, double s,
+        uint_fast64_t n ) {
+    __m256d v = _mm256_set1_pd(s);
+    for ( uint_fast64_t i = 0; i < n; i += 8 ) {
+        _mm256_store_pd(a + i, _mm256_fmadd_pd(v, _mm256_load_pd(c + i),
+                    _mm256_load_pd(b + i)));
+        _mm256_store_pd(a + i + 4, _mm256_fmadd_pd(v,
+                    _mm256_load_pd(c + i + 4), _mm256_load_pd(b + i + 4)));
+    }
+}
+
+__attribute__((target("avx2")))
+void rmw_avx2 ( double *a, double s, uint_fast64_t n ) {
+    __m256d v = _mm256_set1_pd(s);
+    for ( uint_fast64_t i = 0; i < n; i += 8 ) {
+        _mm256_store_pd(a + i, _mm256_add_pd(_mm256_load_pd(a + i), v));
+        _mm256_store_pd(a + i + 4, _mm256_add_pd(_mm256_load_pd(a + i + 4), v));
+    }
+}
+
+__attribute__((target("avx2")))
+void stream_write_avx2 ( double *a, double s, uint_fast64_t n ) {
+    __m256d v = _mm256_set1_pd(s);
+    for ( uint_fast64_t i = 0; i < n; i += 16 ) {
+        _mm256_stream_pd(a + i, v);     _mm256_stream_pd(a + i + 4, v);
+        _mm256_stream_pd(a + i + 8, v); _mm256_stream_pd(a + i + 12, v);
+    }
+    _mm_sfence();
+}
+
+__attribute__((target("avx2")))
+void stream_copy_avx2 ( double *a, const double *b, uint_fast64_t n ) {
+    for ( uint_fast64_t i = 0; i < n; i += 16 ) {
+        _mm256_stream_pd(a + i, _mm256_load_pd(b + i));
+        _mm256_stream_pd(a + i + 4, _mm256_load_pd(b + i + 4));
+        _mm256_stream_pd(a + i + 8, _mm256_load_pd(b + i + 8));
+        _mm256_stream_pd(a + i + 12, _mm256_load_pd(b + i + 12));
+    }
+    _mm_sfence();
+}
+
+__attribute__((target("avx512f")))
+double read_avx512 ( const double *a, uint_fast64_t n ) {
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    __m512d s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+    for ( uint_fast64_t i = 0; i < n; i += 32 ) {
+        s0 = _mm512_add_pd(s0, _mm512_load_pd(a + i));
+        s1 = _mm512_add_pd(s1, _mm512_load_pd(a + i + 8));
+        s2 = _mm512_add_pd(s2, _mm512_load_pd(a + i + 16));
+        s3 = _mm512_add_pd(s3, _mm512_load_pd(a + i + 24));
+    }
+    double out[8];
+    _mm512_storeu_pd(out, _mm512_add_pd(_mm512_add_pd(s0, s1),
+                _mm512_add_pd(s2, s3)));
+    return out[0] + out[1] + out[2] + out[3] + out[4] + out[5] + out[6] + out[7];
+}
+
+__attribute__((target("avx512f")))
+void write_avx512 ( double *a, double s, uint_fast64_t n ) {
+    __m512d v = _mm512_set1_pd(s);
+    for ( uint_fast64_t i = 0; i < n; i += 32 ) {
+        _mm512_store_pd(a + i, v);      _mm512_store_pd(a + i + 8, v);
+        _mm512_store_pd(a + i + 16, v); _mm512_store_pd(a + i + 24, v);
+    }
+}
+
+__attribute__((target("avx512f")))
+void copy_avx512 ( double *a, const double *b, uint_fast64_t n ) {
+    for ( uint_fast64_t i = 0; i < n; i += 32 ) {
+        _mm512_store_pd(a + i, _mm512_load_pd(b + i));
+        _mm512_store_pd(a + i + 8, _mm512_load_pd(b + i + 8));
+        _mm512_store_pd(a + i + 16, _mm512_load_pd(b + i + 16));
+        _mm512_store_pd(a + i + 24, _mm512_load_pd(b + i + 24));
+    }
+}
+
+__attribute__((target("avx512f")))
+void triad_avx512 ( double *a, const double *b, const double *c, double s,
+        uint_fast64_t n ) {
+    __m512d v = _mm512_set1_pd(s);
+    for ( uint_fast64_t i = 0; i < n; i += 16 ) {
+        _mm512_store_pd(a + i, _mm512_fmadd_pd(v, _mm512_load_pd(c + i),
+                    _mm512_load_pd(b + i)));
+        _mm512_store_pd(a + i + 8, _mm512_fmadd_pd(v,
+                    _mm512_load_pd(c + i + 8), _mm512_load_pd(b + i + 8)));
+    }
+}
+
+__attribute__((target("avx512f")))
+void rmw_avx512 ( double *a, double s, uint_fast64_t n ) {
+    __m512d v = _mm512_set1_pd(s);
+    for ( uint_fast64_t i = 0; i < n; i += 16 ) {
+        _mm512_store_pd(a + i, _mm512_add_pd(_mm512_load_pd(a + i), v));
+        _mm512_store_pd(a + i + 8, _mm512_add_pd(_mm512_load_pd(a + i + 8), v));
+    }
+}
+
+__attribute__((target("avx512f")))
+void stream_write_avx512 ( double *a, double s, uint_fast64_t n ) {
+    __m512d v = _mm512_set1_pd(s);
+    for ( uint_fast64_t i = 0; i < n; i += 32 ) {
+        _mm512_stream_pd(a + i, v);      _mm512_stream_pd(a + i + 8, v);
+        _mm512_stream_pd(a + i + 16, v); _mm512_stream_pd(a + i + 24, v);
+    }
+    _mm_sfence();
+}
+
+__attribute__((target("avx512f")))
+void stream_copy_avx512 ( double *a, const double *b, uint_fast64_t n ) {
+    for ( uint_fast64_t i = 0; i < n; i += 32 ) {
+        _mm512_stream_pd(a + i, _mm512_load_pd(b + i));
+        _mm512_stream_pd(a + i + 8, _mm512_load_pd(b + i + 8));
+        _mm512_stream_pd(a + i + 16, _mm512_load_pd(b + i + 16));
+        _mm512_stream_pd(a + i + 24, _mm512_load_pd(b + i + 24));
+    }
+    _mm_sfence();
+}
+
+// Flush loops over the lines of size bytes, ending with a store fence so
+// that every write back is complete
+
+void flush_clflush ( const char *p, uint_fast64_t size ) {
+    for ( uint_fast64_t i = 0; i < size; i += 64 ) _mm_clflush(p + i);
+    _mm_sfence();
+}
+
+__attribute__((target("clflushopt")))
+void flush_clflushopt ( const char *p, uint_fast64_t size ) {
+    for ( uint_fast64_t i = 0; i < size; i += 64 ) _mm_clflushopt((void*) ( p + i ));
+    _mm_sfence();
+}
+
+__attribute__((target("clwb")))
+void flush_clwb ( const char *p, uint_fast64_t size ) {
+    for ( uint_fast64_t i = 0; i < size; i += 64 ) _mm_clwb((void*) ( p + i ));
+    _mm_sfence();
+}
+
+#endif
+
+/****************************************************************************/
+// Method implementations
+
+// Runtime detection of the instruction set
+VectorIsa best_vector_isa (  ) {
+#ifdef TOPOPERF_X86
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports("avx512f") ) return AVX512;
+    if ( __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") )
+        return AVX2;
+    if ( __builtin_cpu_supports("sse2") ) return SSE2;
+#endif
+    return SCALAR;
+}
+
+// Kernel selection
+// Falls back to the scalar kernels when the ISA was not compiled in
+BandwidthKernels kernels_for ( VectorIsa isa ) {
+#ifdef TOPOPERF_X86
+    if ( isa == AVX512 )
+        return { AVX512, read_avx512, write_avx512, copy_avx512, triad_avx512,
+            rmw_avx512, stream_write_avx512, stream_copy_avx512 };
+    if ( isa == AVX2 )
+        return { AVX2, read_avx2, write_avx2, copy_avx2, triad_avx2,
+            rmw_avx2, stream_write_avx2, stream_copy_avx2 };
+    if ( isa == SSE2 )
+        return { SSE2, read_sse2, write_sse2, copy_sse2, triad_sse2,
+            rmw_sse2, stream_write_sse2, stream_copy_sse2 };
+#endif
+    return { SCALAR, read_scalar, write_scalar, copy_scalar, triad_scalar,
+        rmw_scalar, stream_write_scalar, stream_copy_scalar };
+}
+
+string kernel_name ( BandwidthKernel kernel ) {
+    if ( kernel == READ ) return "read";
+    else if ( kernel == WRITE ) return "write";
+    else if ( kernel == COPY ) return "copy";
+    else if ( kernel == TRIAD ) return "triad";
+    else if ( kernel == RMW ) return "rmw";
+    else if ( kernel == STREAM_WRITE ) return "stream_write";
+    else return "stream_copy";
+}
+
+// Bytes moved by a kernel
+// Follows the STREAM convention: write-allocate traffic is not counted (it
+// is what non-temporal stores avoid), and RMW counts its read and its write
+uint_fast64_t kernel_bytes ( BandwidthKernel kernel, uint_fast64_t n ) {
+    if ( kernel == READ || kernel == WRITE || kernel == STREAM_WRITE )
+        return n * sizeof(double);
+    else if ( kernel == TRIAD ) return 3ul * n * sizeof(double);
+    else return 2ul * n * sizeof(double);
+}
+
+// Flush instruction detection (CPUID leaf 7: EBX bit 23 for CLFLUSHOPT and
+// bit 24 for CLWB). CLFLUSH is part of SSE2
+bool flush_supported ( FlushInstruction instruction ) {
+#ifdef TOPOPERF_X86
+    if ( instruction == CLFLUSH ) return true;
+    unsigned eax, ebx, ecx, edx;
+    if ( ! __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) ) return false;
+    return ( ebx >> ( instruction == CLFLUSHOPT ? 23 : 24 ) ) & 1u;
+#else
+    (void) instruction;
+    return false;
+#endif
+}
+
+string flush_name ( FlushInstruction instruction ) {
+    if ( instruction == CLFLUSH ) return "clflush";
+    else if ( instruction == CLFLUSHOPT ) return "clflushopt";
+    else return "clwb";
+}
+
+BandwidthEngine::BandwidthEngine ( unsigned threads, vector<int> cpus,
+        uint_fast64_t traffic, VectorIsa isa ) :
+    threads_ ( threads == 0 ? 1u : threads ),
+    traffic_ ( traffic ),
+    kernels_ ( kernels_for(isa) ),
+    page_size_ ( sysconf(_SC_PAGESIZE) ) {
+    vector<int> allowed = cpus.empty() ? allowed_cpus() : cpus;
+    for ( unsigned t = 0; t < threads_; ++t )
+        cpus_.push_back(allowed[t % allowed.size()]);
+}
+
+void BandwidthEngine::release (  ) {
+    if ( owned_ ) for ( double *array : arrays_ ) free(array);
+    arrays_.clear();
+    capacity_ = 0;
+}
+
+// Arena splitting
+// Arrays are rounded down to whole kernel blocks and aligned to 4 KiB
+void BandwidthEngine::attach ( BufferArena &arena ) {
+    release();
+    uint_fast64_t bytes = arena.size() / ( 3ul * threads_ ) & ~4095ul;
+    uint_fast64_t n = bytes / sizeof(double) / KERNEL_BLOCK * KERNEL_BLOCK;
+    if ( n == 0 )
+        throw length_error("arena too small for " + to_string(threads_) +
+                " threads");
+    for ( unsigned a = 0; a < 3 * threads_; ++a )
+        arrays_.push_back(arena.view<double>(bytes, a * bytes));
+    owned_ = false;
+    capacity_ = n;
+    page_size_ = arena.page_size();
+}
+
+// Array allocation
+// Every thread initializes its own arrays after being pinned, so that pages
+// are placed on the memory node of its CPU (first touch policy)
+void BandwidthEngine::reserve ( uint_fast64_t size ) {
+    uint_fast64_t n = max(size / sizeof(double), KERNEL_BLOCK);
+    n = (n + KERNEL_BLOCK - 1) / KERNEL_BLOCK * KERNEL_BLOCK;
+    if ( n <= capacity_ ) return;
+    if ( ! owned_ )
+        throw length_error("arrays of " + to_string(size) +
+                " bytes exceed the attached arena");
+    release();
+    arrays_.assign(3ul * threads_, nullptr);
+    for ( double *&array : arrays_ ) {
+        void *memory = nullptr;
+        if ( posix_memalign(&memory, 4096, n * sizeof(double)) != 0 ) {
+            release();
+            throw bad_alloc();
+        }
+        array = static_cast<double*>(memory);
+    }
+    capacity_ = n;
+
+    vector<thread> workers;
+    for ( unsigned t = 0; t < threads_; ++t )
+        workers.emplace_back( [this, t, n] (  ) {
+            pin_current_thread(cpus_[t]);
+            for ( unsigned k = 0; k < 3; ++k )
+                for ( uint_fast64_t i = 0; i < n; ++i )
+                    arrays_[3 * t + k][i] = 1.0;
+        } );
+    for ( thread &worker : workers ) worker.join();
+}
+
+// Kernel repetitions of one thread
+double BandwidthEngine::run ( BandwidthKernel kernel, unsigned thread,
+        uint_fast64_t n, uint_fast64_t repetitions ) {
+    double *a = arrays_[3 * thread];
+    double *b = arrays_[3 * thread + 1];
+    double *c = arrays_[3 * thread + 2];
+    double sum = 0.0;
+    for ( uint_fast64_t r = 0; r < repetitions; ++r ) {
+        if ( kernel == READ ) sum += kernels_.read(a, n);
+        else if ( kernel == WRITE ) kernels_.write(a, (double) r, n);
+        else if ( kernel == COPY ) kernels_.copy(a, b, n);
+        else if ( kernel == TRIAD ) kernels_.triad(a, b, c, 3.0, n);
+        else if ( kernel == RMW ) kernels_.rmw(a, 1.0, n);
+        else if ( kernel == STREAM_WRITE ) kernels_.stream_write(a, (double) r, n);
+        else kernels_.stream_copy(a, b, n);
+    }
+    return sum;
+}
+
+// Bandwidth measurement
+// Threads run one untimed pass, meet at a barrier, and run enough passes to
+// move at least traffic_ bytes each. The time is taken by the first thread
+// between two barriers, so it covers the slowest thread.
+double BandwidthEngine::measure ( BandwidthKernel kernel, uint_fast64_t size ) {
+    reserve(size);
+    uint_fast64_t n = max(size / sizeof(double), KERNEL_BLOCK);
+    n = n / KERNEL_BLOCK * KERNEL_BLOCK;
+    uint_fast64_t bytes = kernel_bytes(kernel, n);
+    uint_fast64_t repetitions = max(traffic_ / bytes, (uint_fast64_t) 1ul);
+
+    SpinBarrier barrier(threads_);
+    chrono::steady_clock::time_point begin, finish;
+    vector<double> sinks(threads_);
+    vector<thread> workers;
+    for ( unsigned t = 0; t < threads_; ++t )
+        workers.emplace_back( [&, t] (  ) {
+            pin_current_thread(cpus_[t]);
+            sinks[t] = run(kernel, t, n, 1);
+            barrier.wait();
+            if ( t == 0 ) begin = chrono::steady_clock::now();
+            sinks[t] += run(kernel, t, n, repetitions);
+            barrier.wait();
+            if ( t == 0 ) finish = chrono::steady_clock::now();
+        } );
+    for ( thread &worker : workers ) worker.join();
+
+    volatile double sink = 0.0;
+    for ( double value : sinks ) sink = sink + value;
+
+    double seconds = chrono::duration<double>(finish - begin).count();
+    return (double) bytes * repetitions * threads_ / seconds / 1e9;
+}
+
+// Sweep over the sizes of a generator
+vector<BandwidthPoint> BandwidthEngine::sweep ( DistributionGenerator *generator,
+        const vector<BandwidthKernel> &kernels ) {
+    vector<uint_fast64_t> sizes;
+    while ( ! generator->is_done() ) sizes.push_back(generator->next());
+    return sweep(sizes, kernels);
+}
+
+// Sweep over a list of sizes
+// Arrays are reserved at the largest size before the first measurement
+vector<BandwidthPoint> BandwidthEngine::sweep ( const vector<uint_fast64_t> &sizes,
+        const vector<BandwidthKernel> &kernels ) {
+    if ( ! sizes.empty() ) reserve(*max_element(sizes.begin(), sizes.end()));
+
+    vector<BandwidthPoint> points;
+    for ( uint_fast64_t size : sizes )
+        for ( BandwidthKernel kernel : kernels )
+            points.push_back( { size, kernel, threads_,
+                    measure(kernel, size), page_size_ } );
+    return points;
+}
+
+// Flush measurement
+// Before every timed flush the lines are written again with regular stores
+// (not timed), so that every flush writes back a dirty line. Only the first
+// thread of the engine is used
+double BandwidthEngine::measure_flush ( FlushInstruction instruction,
+        uint_fast64_t size ) {
+#ifdef TOPOPERF_X86
+    if ( ! flush_supported(instruction) ) return 0.0;
+    reserve(size);
+    uint_fast64_t n = max(size / sizeof(double), KERNEL_BLOCK);
+    n = n / KERNEL_BLOCK * KERNEL_BLOCK;
+    uint_fast64_t bytes = n * sizeof(double);
+    uint_fast64_t repetitions = max(traffic_ / bytes, (uint_fast64_t) 1ul);
+    void (*flush) ( const char *, uint_fast64_t ) =
+        instruction == CLFLUSH ? flush_clflush :
+        ( instruction == CLFLUSHOPT ? flush_clflushopt : flush_clwb );
+
+    double ns = 0.0;
+    thread worker( [&] (  ) {
+        pin_current_thread(cpus_[0]);
+        double *a = arrays_[0];
+        for ( uint_fast64_t r = 0; r <= repetitions; ++r ) {
+            kernels_.write(a, (double) r, n);
+            auto begin = chrono::steady_clock::now();
+            flush((const char*) a, bytes);
+            auto finish = chrono::steady_clock::now();
+            // The first repetition is a warm-up
+            if ( r > 0 ) ns += chrono::duration<double, nano>(finish - begin).count();
+        }
+    } );
+    worker.join();
+    return ns / repetitions / ( bytes / 64 );
+#else
+    (void) instruction;
+    (void) size;
+    return 0.0;
+#endif
+}
+
+vector<FlushPoint> BandwidthEngine::flush_sweep ( DistributionGenerator *generator,
+        const vector<FlushInstruction> &instructions ) {
+    vector<uint_fast64_t> sizes;
+    while ( ! generator->is_done() ) sizes.push_back(generator->next());
+    if ( ! sizes.empty() ) reserve(*max_element(sizes.begin(), sizes.end()));
+
+    vector<FlushPoint> points;
+    for ( uint_fast64_t size : sizes )
+        for ( FlushInstruction instruction : instructions ) {
+            if ( ! flush_supported(instruction) ) continue;
+            double ns = measure_flush(instruction, size);
+            points.push_back( { size, instruction, ns, 64.0 / ns } );
+        }
+    return points;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cmath>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "distribution_generator.hpp"
+#include "pointer_chase.hpp"
+
+using namespace std;
+
+// Classes in this file
+class BoundaryDetector;
+
+// Capacity boundary bracketed between two measured sizes
+struct Boundary {
+    uint_fast64_t lower;    //Largest size measured before the jump
+    uint_fast64_t upper;    //Smallest size measured after the jump
+    double latency_below;   //Latency of the level before the jump
+    double latency_above;   //Latency of the level after the jump
+};
+
+/****************************************************************************/
+// Detects the capacity of cache levels (or TLB reach, when measuring with one
+// slot per page) from the jumps of a latency curve.
+// A coarse ExponentiallySpaced sweep finds the intervals where the latency
+// jumps by more than a factor. Each interval is then refined with MidPoint
+// generators while it is wide, and with UniformlySpaced generators once it is
+// narrow, until the boundary is bracketed to the requested relative precision.
+// The boundary is where the latency crosses the geometric mean of the levels
+// around the jump.
+// Example of use:
+//   PointerChase chase;
+//   BoundaryDetector detector(chase);
+//   for ( Boundary &boundary : detector.detect(1024, 1ul << 30) )
+//       std::cout << boundary.lower << " " << boundary.upper << std::endl;
+class BoundaryDetector {
+    private:
+        function<double(uint_fast64_t)> measure_;   //Latency of a size
+        double precision_;          //Maximum relative width of a bracket
+        double jump_;               //Latency ratio that reveals a boundary
+        uint_fast64_t refine_points_;   //Points per UniformlySpaced step
+        map<uint_fast64_t, double> latencies_;  //Every size measured
+
+        //Measures a size, unless it was measured before
+        double latency ( uint_fast64_t size );
+        //Measures every point of a generator and returns them sorted
+        vector<uint_fast64_t> points ( DistributionGenerator *generator );
+        //Narrows the bracket of one boundary
+        Boundary refine ( Boundary boundary );
+
+    public:
+        //Constructor with the measurement function, the precision of the
+        //brackets, the latency jump factor and the number of points used
+        //by each UniformlySpaced refinement step
+        BoundaryDetector ( function<double(uint_fast64_t)> measure,
+                double precision = 0.05, double jump = 1.25,
+                uint_fast64_t refine_points = 3ul );
+        //Constructor measuring with a pointer chase
+        BoundaryDetector ( PointerChase &chase, double precision = 0.05,
+                double jump = 1.25, uint_fast64_t refine_points = 3ul );
+
+        //Detects boundaries between min and max, starting from a coarse
+        //sweep of coarse_points sizes
+        vector<Boundary> detect ( uint_fast64_t min, uint_fast64_t max,
+                uint_fast64_t coarse_points = 24ul );
+        //Number of sizes measured so far
+        uint_fast64_t measurements (  ) const { return latencies_.size(); }
+        //Latency of every size measured so far
+        const map<uint_fast64_t, double> &latencies (  ) const {
+            return latencies_;
+        }
+};
+
+/****************************************************************************/
+// Method implementations
+
+BoundaryDetector::BoundaryDetector ( function<double(uint_fast64_t)> measure,
+        double precision, double jump, uint_fast64_t refine_points ) :
+    measure_ ( measure ), precision_ ( precision ), jump_ ( jump ),
+    refine_points_ ( refine_points == 0 ? 1ul : refine_points ) {  }
+
+BoundaryDetector::BoundaryDetector ( PointerChase &chase, double precision,
+        double jump, uint_fast64_t refine_points ) :
+    BoundaryDetector ( [&chase] ( uint_fast64_t size ) {
+                chase.prepare(size);
+                return chase.measure();
+            }, precision, jump, refine_points ) {  }
+
+double BoundaryDetector::latency ( uint_fast64_t size ) {
+    auto found = latencies_.find(size);
+    if ( found != latencies_.end() ) return found->second;
+    double value = measure_(size);
+    latencies_[size] = value;
+    return value;
+}
+
+vector<uint_fast64_t> BoundaryDetector::points ( DistributionGenerator *generator ) {
+    vector<uint_fast64_t> sizes = generator->generate_n(UINT_FAST64_MAX);
+    delete generator;
+    sort(sizes.begin(), sizes.end());
+    sizes.erase(unique(sizes.begin(), sizes.end()), sizes.end());
+    for ( uint_fast64_t size : sizes ) latency(size);
+    return sizes;
+}
+
+// Boundary refinement
+// Every step keeps the largest size below the threshold as lower limit and
+// the first size above it as upper limit. Steps that cannot find new sizes
+// (brackets of consecutive integers) stop the refinement
+Boundary BoundaryDetector::refine ( Boundary boundary ) {
+    double threshold = sqrt(boundary.latency_below * boundary.latency_above);
+    while ( (double) boundary.upper / boundary.lower - 1.0 > precision_ ) {
+        DistributionGenerator *generator;
+        if ( boundary.upper > 2ul * boundary.lower )
+            generator = DistributionGenerator::make_generator(
+                    boundary.lower, boundary.upper, MID_POINT, 1ul);
+        else
+            generator = DistributionGenerator::make_generator(
+                    boundary.lower, boundary.upper, UNIFORMLY_SPACED,
+                    refine_points_);
+        bool narrowed = false;
+        for ( uint_fast64_t size : points(generator) ) {
+            if ( size <= boundary.lower || size >= boundary.upper ) continue;
+            narrowed = true;
+            if ( latency(size) < threshold ) boundary.lower = size;
+            else {
+                boundary.upper = size;
+                break;
+            }
+        }
+        if ( ! narrowed ) break;
+    }
+    return boundary;
+}
+
+// Boundary detection
+// Consecutive jumps of the coarse sweep are either one cache level that takes
+// several coarse points to fill, or several levels whose boundaries fall on
+// adjacent points. Every jump is refined, and two consecutive jumps are kept
+// apart when the latency does not jump between the upper size of the first
+// and the lower size of the second (a plateau of the level between them).
+// Other consecutive jumps are merged into one boundary
+vector<Boundary> BoundaryDetector::detect ( uint_fast64_t min, uint_fast64_t max,
+        uint_fast64_t coarse_points ) {
+    vector<uint_fast64_t> sizes = points(DistributionGenerator::make_generator(
+                min, max, EXPONENTIALLY_SPACED, coarse_points));
+    sizes.insert(sizes.begin(), min);
+    sizes.push_back(max);
+    sort(sizes.begin(), sizes.end());
+    sizes.erase(unique(sizes.begin(), sizes.end()), sizes.end());
+    auto bracket = [&] ( uint_fast64_t first, uint_fast64_t last ) {
+        return refine( { sizes[first], sizes[last], latency(sizes[first]),
+                latency(sizes[last]) } );
+    };
+
+    vector<Boundary> boundaries;
+    uint_fast64_t i = 0;
+    while ( i + 1 < sizes.size() ) {
+        if ( latency(sizes[i + 1]) <= jump_ * latency(sizes[i]) ) {
+            ++i;
+            continue;
+        }
+        uint_fast64_t j = i + 1;
+        while ( j + 1 < sizes.size() &&
+                latency(sizes[j + 1]) > jump_ * latency(sizes[j]) ) ++j;
+        uint_fast64_t first = i;
+        Boundary previous = bracket(i, i + 1);
+        for ( uint_fast64_t k = i + 1; k < j; ++k ) {
+            Boundary next = bracket(k, k + 1);
+            if ( previous.upper < next.lower &&
+                    latency(next.lower) <= jump_ * latency(previous.upper) ) {
+                boundaries.push_back(bracket(first, k));
+                first = k;
+            }
+            previous = next;
+        }
+        boundaries.push_back(bracket(first, j));
+        i = j;
+    }
+    return boundaries;
+}
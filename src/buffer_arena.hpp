@@ -0,0 +1,205 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "distribution_generator.hpp"
+
+using namespace std;
+
+// Classes in this file
+class BufferArena;
+
+// Pages backing a measurement buffer
+enum PageKind {
+    SMALL_PAGES,        // Base pages (4 KiB on x86), huge pages disabled
+    TRANSPARENT_HUGE,   // Base pages promoted by THP (madvise)
+    HUGE_2M,            // 2 MiB pages from hugetlbfs (MAP_HUGETLB)
+    HUGE_1G             // 1 GiB pages from hugetlbfs (MAP_HUGETLB)
+};
+
+// Returns the name of a kind of page
+string page_kind_name ( PageKind kind );
+
+/****************************************************************************/
+// Memory for measurement buffers, allocated once and pre-faulted.
+// The arena is mapped with the requested kind of page. When hugetlbfs pages
+// are not available it falls back to smaller ones (1 GiB, then 2 MiB, then
+// transparent huge pages), and page_kind tells what was obtained. Every page
+// is written once at construction, so no page fault happens in a sweep.
+// Transparent huge pages are only reported when the kernel promoted most of
+// the arena (THP may be disabled, or memory too fragmented); otherwise the
+// arena reports base pages.
+// Example of use:
+//   DistributionGenerator *generator = DistributionGenerator::make_generator(
+//       4096, 1ul<<30, EXPONENTIALLY_SPACED, 30);
+//   BufferArena arena(*generator, HUGE_2M);
+//   PointerChase chase;
+//   chase.attach(arena);
+//   chase.sweep(generator);
+class BufferArena {
+    private:
+        void *memory_ = MAP_FAILED;     //Mapped memory
+        uint_fast64_t size_ = 0;        //Mapped size (whole pages)
+        PageKind kind_;                 //Kind of page obtained
+        uint_fast64_t page_size_;       //Size of the pages obtained
+        double fault_ns_;               //Time to map and pre-fault the arena
+
+        //Tries to map size bytes with a kind of page
+        bool map ( uint_fast64_t size, PageKind kind );
+
+    public:
+        //Constructor with the size and the preferred kind of page
+        BufferArena ( uint_fast64_t size, PageKind kind = HUGE_2M );
+        //Constructor sized for the largest point of a generator
+        BufferArena ( const DistributionGenerator &generator,
+                PageKind kind = HUGE_2M );
+        ~BufferArena (  );
+        BufferArena ( const BufferArena & ) = delete;
+        BufferArena &operator= ( const BufferArena & ) = delete;
+
+        //Start of the arena
+        void *data (  ) const { return memory_; }
+        //Usable size of the arena in bytes
+        uint_fast64_t size (  ) const { return size_; }
+        //Kind of page backing the arena
+        PageKind page_kind (  ) const { return kind_; }
+        //Size of the pages backing the arena
+        uint_fast64_t page_size (  ) const { return page_size_; }
+        //Nanoseconds taken by the mapping that succeeded and by the first
+        //touch of every page, without the check of THP promotion
+        double fault_ns (  ) const { return fault_ns_; }
+        //Returns size bytes of the arena starting at offset, as an array of T
+        template <typename T>
+        T *view ( uint_fast64_t size, uint_fast64_t offset = 0ul ) const;
+
+        //Bytes of the mapping containing address counted by a field of its
+        //entry in /proc/self/smaps (AnonHugePages by default: the bytes
+        //backed by transparent huge pages), 0 if unknown
+        static uint_fast64_t huge_bytes ( const void *address,
+                const string &field = "AnonHugePages" );
+};
+
+/****************************************************************************/
+// Method implementations
+
+string page_kind_name ( PageKind kind ) {
+    if ( kind == SMALL_PAGES ) return "4k";
+    else if ( kind == TRANSPARENT_HUGE ) return "thp";
+    else if ( kind == HUGE_2M ) return "2m";
+    else return "1g";
+}
+
+// Mapping of one kind of page
+// The size is rounded up to whole pages of that kind
+bool BufferArena::map ( uint_fast64_t size, PageKind kind ) {
+    uint_fast64_t base = sysconf(_SC_PAGESIZE);
+    uint_fast64_t page = kind == HUGE_1G ? 1ul << 30 :
+        ( kind == SMALL_PAGES ? base : 1ul << 21 );
+    uint_fast64_t rounded = ( size + page - 1 ) / page * page;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_HUGETLB
+    if ( kind == HUGE_2M ) flags |= MAP_HUGETLB | ( 21 << MAP_HUGE_SHIFT );
+    if ( kind == HUGE_1G ) flags |= MAP_HUGETLB | ( 30 << MAP_HUGE_SHIFT );
+#else
+    if ( kind == HUGE_2M || kind == HUGE_1G ) return false;
+#endif
+
+    // THP needs 2 MiB aligned regions, so a larger region is mapped and the
+    // unaligned head and tail are unmapped
+    uint_fast64_t mapped = kind == TRANSPARENT_HUGE ? rounded + page : rounded;
+    void *memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if ( memory == MAP_FAILED ) return false;
+    if ( kind == TRANSPARENT_HUGE ) {
+        uintptr_t start = (uintptr_t) memory;
+        uintptr_t aligned = ( start + page - 1 ) & ~( page - 1 );
+        if ( aligned > start ) munmap(memory, aligned - start);
+        uintptr_t end = start + mapped;
+        if ( end > aligned + rounded )
+            munmap((void*) ( aligned + rounded ), end - aligned - rounded);
+        memory = (void*) aligned;
+    }
+#ifdef MADV_HUGEPAGE
+    if ( kind == TRANSPARENT_HUGE ) madvise(memory, rounded, MADV_HUGEPAGE);
+    if ( kind == SMALL_PAGES ) madvise(memory, rounded, MADV_NOHUGEPAGE);
+#endif
+
+    memory_ = memory;
+    size_ = rounded;
+    kind_ = kind;
+    page_size_ = page;
+    return true;
+}
+
+// Allocation with fallback to smaller pages, and pre-faulting
+// Pages are written (not only read), so they are not mapped to the zero page
+BufferArena::BufferArena ( uint_fast64_t size, PageKind kind ) {
+    if ( size == 0 ) size = 1;
+    bool mapped = false;
+    auto begin = chrono::steady_clock::now();
+    for ( int k = kind; k >= SMALL_PAGES && ! mapped; --k ) {
+        begin = chrono::steady_clock::now();
+        mapped = map(size, (PageKind) k);
+    }
+    if ( ! mapped ) throw bad_alloc();
+
+    uint_fast64_t base = sysconf(_SC_PAGESIZE);
+    volatile char *bytes = (volatile char*) memory_;
+    for ( uint_fast64_t offset = 0; offset < size_; offset += base )
+        bytes[offset] = 0;
+    fault_ns_ = chrono::duration<double, nano>(
+            chrono::steady_clock::now() - begin).count();
+
+    // Promotion happens at the first touch, so it is known once pre-faulted
+    if ( kind_ == TRANSPARENT_HUGE && 2ul * huge_bytes(memory_) < size_ ) {
+        kind_ = SMALL_PAGES;
+        page_size_ = base;
+    }
+}
+
+// Transparent huge pages of a mapping
+// Header lines of smaps give the range of each mapping, followed by its
+// fields. The mapping may include adjacent arenas merged by the kernel
+uint_fast64_t BufferArena::huge_bytes ( const void *address,
+        const string &field ) {
+    ifstream smaps("/proc/self/smaps");
+    string line;
+    bool inside = false;
+    while ( getline(smaps, line) ) {
+        unsigned long long begin, end;
+        if ( sscanf(line.c_str(), "%llx-%llx ", &begin, &end) == 2 &&
+                line.find(':') > line.find(' ') ) {
+            inside = begin <= (uintptr_t) address && (uintptr_t) address < end;
+            continue;
+        }
+        unsigned long long kilobytes;
+        if ( inside && line.compare(0, field.size() + 1, field + ":") == 0 &&
+                sscanf(line.c_str() + field.size() + 1, " %llu kB", &kilobytes) == 1 )
+            return kilobytes << 10;
+    }
+    return 0ul;
+}
+
+BufferArena::BufferArena ( const DistributionGenerator &generator,
+        PageKind kind ) :
+    BufferArena ( generator.upper_limit(), kind ) {  }
+
+BufferArena::~BufferArena (  ) {
+    if ( memory_ != MAP_FAILED ) munmap(memory_, size_);
+}
+
+// Sub-views
+// Views share the arena memory, so nothing is allocated or faulted in
+template <typename T>
+T *BufferArena::view ( uint_fast64_t size, uint_fast64_t offset ) const {
+    if ( offset > size_ || size > size_ - offset )
+        throw out_of_range("view of " + to_string(size) + " bytes at " +
+                to_string(offset) + " exceeds arena of " + to_string(size_));
+    return (T*) ( (char*) memory_ + offset );
+}
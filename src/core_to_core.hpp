@@ -0,0 +1,184 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "distribution_generator.hpp"
+#include "threading.hpp"
+
+using namespace std;
+
+// Classes in this file
+class CoreToCore;
+
+// Ways of handing a cache line from one core to another
+enum TransferKind {
+    PING_PONG,          // Atomic read-modify-write (fetch_add) on the line
+    SHARED_TO_MODIFIED  // Plain store to a line the other core is reading
+};
+
+// Latency of one transfer between two CPUs
+struct TransferPoint {
+    int from;               //CPU starting each round trip
+    int to;                 //CPU answering each round trip
+    uint_fast64_t payload;  //Bytes moved with the flag line (0: flag only)
+    TransferKind kind;      //How the flag line is handed over
+    double ns_per_transfer; //One-way latency (half a round trip)
+};
+
+// Returns the name of a kind of transfer
+string transfer_kind_name ( TransferKind kind );
+
+/****************************************************************************/
+// Cache line transfer latency between pairs of CPUs.
+// Two pinned threads take turns on a flag in its own cache line: the first
+// one publishes odd values and the second one answers with even values, so
+// every turn moves the line from one core to the other. With a payload, the
+// thread holding the turn writes payload bytes (whole cache lines) before
+// publishing the flag and the other thread reads them after seeing it, as
+// in a message passing queue. The result is half of the round trip time.
+// Waiting threads yield after a long spin, so two threads on the same CPU
+// still make progress (slowly) instead of spinning for a whole time slice.
+// Example of use:
+//   CoreToCore transfers;
+//   //Latency between every pair of CPUs, row by row
+//   for ( TransferPoint &point : transfers.matrix() )
+//       std::cout << point.from << " " << point.to << " "
+//           << point.ns_per_transfer << std::endl;
+class CoreToCore {
+    private:
+        vector<int> cpus_;              //CPUs of the matrix
+        uint_fast64_t round_trips_;     //Timed round trips per measurement
+
+        //Spins until the flag holds value
+        static void wait_for ( const atomic<uint_fast64_t> &flag,
+                uint_fast64_t value );
+
+    public:
+        //Constructor with the CPUs of the matrix (the allowed CPUs if empty)
+        //and the number of timed round trips of each measurement
+        CoreToCore ( vector<int> cpus = vector<int>(),
+                uint_fast64_t round_trips = 1ul << 16 );
+
+        //CPUs of the matrix
+        const vector<int> &cpus (  ) const { return cpus_; }
+        //Measures the one-way transfer latency between two CPUs (in ns)
+        double measure ( int from, int to, TransferKind kind = PING_PONG,
+                uint_fast64_t payload = 0ul );
+        //Measures every pair of CPUs. The result has N x N points ordered by
+        //row (from) and column (to); the diagonal is not measured and is 0
+        vector<TransferPoint> matrix ( TransferKind kind = PING_PONG,
+                uint_fast64_t payload = 0ul );
+        //Measures every payload size provided by the generator between two CPUs
+        vector<TransferPoint> sweep ( int from, int to,
+                DistributionGenerator *generator,
+                TransferKind kind = SHARED_TO_MODIFIED );
+};
+
+/****************************************************************************/
+// Method implementations
+
+string transfer_kind_name ( TransferKind kind ) {
+    if ( kind == PING_PONG ) return "ping_pong";
+    else return "shared_to_modified";
+}
+
+CoreToCore::CoreToCore ( vector<int> cpus, uint_fast64_t round_trips ) :
+    cpus_ ( cpus.empty() ? allowed_cpus() : cpus ),
+    round_trips_ ( round_trips == 0 ? 1ul : round_trips ) {  }
+
+// Flag waiting
+// Between two threads on different cores the answer arrives long before the
+// spin limit, so yield is only reached when both threads share a CPU
+void CoreToCore::wait_for ( const atomic<uint_fast64_t> &flag,
+        uint_fast64_t value ) {
+    for ( uint_fast64_t spins = 1; flag.load(memory_order_acquire) != value;
+            ++spins )
+        if ( spins % 4096 == 0 ) this_thread::yield();
+}
+
+// Transfer measurement
+// The flag and the payload are in separate cache lines. A first round trip
+// is not timed, so both threads are running when the clock starts
+double CoreToCore::measure ( int from, int to, TransferKind kind,
+        uint_fast64_t payload ) {
+    uint_fast64_t words = ( payload + 63ul ) / 64ul * 8ul;
+    void *memory = nullptr;
+    if ( posix_memalign(&memory, 64, 64ul + words * sizeof(uint64_t)) != 0 )
+        throw bad_alloc();
+    atomic<uint_fast64_t> *flag = new (memory) atomic<uint_fast64_t>(0);
+    volatile uint64_t *data = (volatile uint64_t*) ( (char*) memory + 64 );
+    for ( uint_fast64_t i = 0; i < words; ++i ) data[i] = 0;
+
+    // Hands the turn to the other thread, which waits for value
+    auto publish = [&] ( uint_fast64_t value ) {
+        for ( uint_fast64_t i = 0; i < words; ++i ) data[i] = value;
+        if ( kind == PING_PONG ) flag->fetch_add(1, memory_order_acq_rel);
+        else flag->store(value, memory_order_release);
+    };
+    // Waits for the turn and reads the payload
+    auto receive = [&] ( uint_fast64_t value ) {
+        wait_for(*flag, value);
+        uint64_t sum = 0;
+        for ( uint_fast64_t i = 0; i < words; ++i ) sum += data[i];
+        return sum;
+    };
+
+    uint_fast64_t trips = round_trips_ + 1;
+    volatile uint64_t sink = 0;
+    thread answering( [&] (  ) {
+        pin_current_thread(to);
+        uint64_t sum = 0;
+        for ( uint_fast64_t i = 0; i < trips; ++i ) {
+            sum += receive(2 * i + 1);
+            publish(2 * i + 2);
+        }
+        sink = sink + sum;
+    } );
+
+    chrono::steady_clock::time_point begin, finish;
+    thread starting( [&] (  ) {
+        pin_current_thread(from);
+        uint64_t sum = 0;
+        for ( uint_fast64_t i = 0; i < trips; ++i ) {
+            if ( i == 1 ) begin = chrono::steady_clock::now();
+            publish(2 * i + 1);
+            sum += receive(2 * i + 2);
+        }
+        finish = chrono::steady_clock::now();
+        sink = sink + sum;
+    } );
+    starting.join();
+    answering.join();
+
+    flag->~atomic<uint_fast64_t>();
+    free(memory);
+    return chrono::duration<double, nano>(finish - begin).count() /
+        ( 2.0 * round_trips_ );
+}
+
+vector<TransferPoint> CoreToCore::matrix ( TransferKind kind,
+        uint_fast64_t payload ) {
+    vector<TransferPoint> points;
+    for ( int from : cpus_ )
+        for ( int to : cpus_ )
+            points.push_back( { from, to, payload, kind,
+                    from == to ? 0.0 : measure(from, to, kind, payload) } );
+    return points;
+}
+
+vector<TransferPoint> CoreToCore::sweep ( int from, int to,
+        DistributionGenerator *generator, TransferKind kind ) {
+    vector<TransferPoint> points;
+    while ( ! generator->is_done() ) {
+        uint_fast64_t payload = generator->next();
+        points.push_back( { from, to, payload, kind,
+                measure(from, to, kind, payload) } );
+    }
+    return points;
+}
@@ -2,6 +2,11 @@
 
 #include <random>
 #include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "random_engine.hpp"
 
 using namespace std;
 
@@ -18,6 +23,135 @@ enum Generators {
     UNIFORMLY_RANDOM,
     EXPONENTIALLY_RANDOM
 };
+
+// Returns the name of a kind of generator (e.g. "exponentially_spaced")
+string generator_name ( Generators generator_kind );
+// Returns the kind of generator with a name. Returns false if none has it
+bool generator_from_name ( const string &name, Generators &generator_kind );
+/****************************************************************************/
+// Point formulas shared by the generators in this file and by the
+// compile-time sequences of static_generators.hpp
+// They are exact for the whole 64-bit range: nothing overflows
+
+// Unsigned integer wide enough for the product of two 64-bit integers
+__extension__ typedef unsigned __int128 uint_wide_t;
+
+// Largest point computed with double precision by the exponential
+// generators. Larger points are computed with long double, whose 64-bit
+// mantissa (on x86) holds every 64-bit integer
+const uint_fast64_t EXACT_DOUBLE_LIMIT = 1ul << 53;
+
+// Average point between two limits
+constexpr uint_fast64_t average_point ( uint_fast64_t min, uint_fast64_t max ) {
+    return min + ( ( max - min ) >> 1 );
+}
+// index-th point of an interval split in parts uniform parts
+// The product is computed in 128 bits only when it may not fit in 64 bits
+constexpr uint_fast64_t uniform_point ( uint_fast64_t min, uint_fast64_t max,
+        uint_fast64_t parts, uint_fast64_t index ) {
+    return ( ( max - min ) | index ) >> 32 == 0 ?
+        min + ( index * ( max - min ) ) / parts :
+        min + (uint_fast64_t) ( ( (uint_wide_t) index * ( max - min ) ) / parts );
+}
+// Nearest multiple of alignment to point that lies between first and last,
+// the first and the last multiples in the interval. Points of an interval
+// without multiples (first > last) are not changed. Powers of two (pages,
+// cache lines) avoid the division
+inline uint_fast64_t aligned_point ( uint_fast64_t point, uint_fast64_t alignment,
+        uint_fast64_t first, uint_fast64_t last ) {
+    if ( first > last ) return point;
+    uint_fast64_t remainder = ( alignment & ( alignment - 1 ) ) == 0 ?
+        point & ( alignment - 1 ) : point % alignment;
+    uint_fast64_t down = point - remainder;
+    if ( remainder >= alignment - remainder && down <= UINT_FAST64_MAX - alignment )
+        down += alignment;
+    return down < first ? first : ( down > last ? last : down );
+}
+// Logarithm of the index-th point of an interval split in parts exponential
+// parts, from the logarithm of the lower limit and the size in log scale
+template <typename Real>
+constexpr Real exponential_exponent ( Real log_min, Real log_range,
+        uint_fast64_t parts, uint_fast64_t index ) {
+    return log_min + ( index * log_range ) / parts;
+}
+
+// Functions with loops can only be constexpr from C++14 on, which the
+// compile-time sequences require. Before, they are inline functions
+#if __cplusplus >= 201402L
+#define LOOP_CONSTEXPR constexpr
+#else
+#define LOOP_CONSTEXPR inline
+#endif
+
+// Logarithms and exponentials of the exponential generators
+// std::log and std::exp are not constexpr, and their results may differ by
+// one ulp from any other implementation, so the generators and the
+// compile-time sequences use these ones: range reduction and series that
+// converge to the precision of Real. Both give the same points as long as
+// they are compiled without contraction into fused multiply-adds
+
+// ln(2) split in a high part with trailing zero bits and a low part
+constexpr double LN2_HI = 6.93147180369123816490e-01;
+constexpr double LN2_LO = 1.90821492927058770002e-10;
+constexpr double LN2 = 6.93147180559945309417e-01;
+
+// Natural logarithm of a positive number
+// x = m * 2^e with m in [sqrt(2)/2, sqrt(2)), and log(m) = 2 * atanh(z) with
+// z = (m - 1) / (m + 1)
+template <typename Real>
+LOOP_CONSTEXPR Real series_log ( Real x ) {
+    int e = 0;
+    while ( x >= (Real) 1.4142135623730951 ) { x /= 2; ++e; }
+    while ( x < (Real) 0.7071067811865476 ) { x *= 2; --e; }
+    Real z = ( x - 1 ) / ( x + 1 );
+    Real z2 = z * z;
+    Real term = z;
+    Real sum = 0;
+    for ( int k = 1; k < 60; k += 2 ) {
+        sum += term / k;
+        term *= z2;
+    }
+    return 2 * sum + e * (Real) LN2_LO + e * (Real) LN2_HI;
+}
+
+// Exponential
+// y = k * ln(2) + r with |r| <= ln(2) / 2, and exp(r) from its Taylor series,
+// summed until the terms no longer change the sum. 2^k is built by squaring,
+// and multiplying by it is exact
+template <typename Real>
+LOOP_CONSTEXPR Real series_exp ( Real y ) {
+    Real scaled = y / (Real) LN2;
+    long k = (long) ( scaled < 0 ? scaled - (Real) 0.5 : scaled + (Real) 0.5 );
+    Real r = ( y - k * (Real) LN2_HI ) - k * (Real) LN2_LO;
+    Real term = 1;
+    Real sum = 1;
+    for ( int n = 1; n < 30 && sum + term != sum; ++n ) {
+        term *= r / n;
+        sum += term;
+    }
+    Real power = 1, square = 2;
+    for ( unsigned long e = k < 0 ? -k : k; e > 0; e >>= 1 ) {
+        if ( e & 1 ) power *= square;
+        square *= square;
+    }
+    return k < 0 ? sum / power : sum * power;
+}
+
+// Point of an exponential generator from the logarithm of the point,
+// rounded to the nearest integer and kept inside the limits (rounding
+// errors near 2^64 cannot overflow the conversion)
+template <typename Real>
+LOOP_CONSTEXPR uint_fast64_t exponential_point ( Real exponent,
+        uint_fast64_t min, uint_fast64_t max ) {
+    Real point = series_exp(exponent) + (Real) 0.5;
+    return point >= (Real) max ? max :
+        ( point <= (Real) min ? min : (uint_fast64_t) point );
+}
+// Maps 64 random bits to a double in [0, 1), using 53 of them (a mantissa)
+constexpr double unit_interval ( uint_fast64_t bits ) {
+    return ( bits >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
 /****************************************************************************/
 // This class serves as a base and as a factory for specific implementations
 // of distributions
@@ -26,22 +160,59 @@ enum Generators {
 //   DistributionGenerator *generator = DistributionGenerator::make_generator(10, 100, UNIFORMLY_SPACED, 20);
 //   //Print all points
 //   while ( ! generator->is_done() ) std::cout << generator->next() << std::endl;
+//   //Or get all points at once
+//   vector<uint_fast64_t> points = generator->generate_n(20);
 class DistributionGenerator {
     protected:
         uint_fast64_t min_;          //Lower limit (included)
         uint_fast64_t max_;          //Upper limit (not included)
         uint_fast64_t count_limit_;  //Number of points that can be generated
         uint_fast64_t count_ = 0;    //Number of points already generated
+        uint_fast64_t alignment_ = 1;    //Points are multiples of alignment_
+        uint_fast64_t first_ = 0, last_ = 0;  //First and last multiples
+
+        //Number of points that can still be generated, limited to n
+        uint_fast64_t remaining ( uint_fast64_t n ) const {
+            return is_done() ? 0ul : min(n, count_limit_ - count_);
+        }
+        //Rounds a point to the nearest multiple of the alignment
+        uint_fast64_t align ( uint_fast64_t point ) const {
+            return alignment_ == 1 ? point :
+                aligned_point(point, alignment_, first_, last_);
+        }
+        //Rounds n points to multiples of the alignment
+        void align ( uint_fast64_t *points, uint_fast64_t n ) const {
+            if ( alignment_ == 1 ) return;
+            for ( uint_fast64_t i = 0; i < n; ++i )
+                points[i] = aligned_point(points[i], alignment_, first_, last_);
+        }
 
     public:
         //Factory method
+        //The seed is only used by random generators. With an alignment
+        //larger than 1, points are rounded to its nearest multiple inside
+        //the limits (e.g. 4096 for whole pages)
         static DistributionGenerator *make_generator (
             uint_fast64_t min, uint_fast64_t max, Generators generator_kind,
-            uint_fast64_t count_limit );
+            uint_fast64_t count_limit, uint_fast64_t seed,
+            uint_fast64_t alignment );
+        //Generators are deleted through base pointers by their users
+        virtual ~DistributionGenerator (  ) {  }
         //Returns true if the generation limit has been achieved
         bool is_done (  ) const { return ! (count_ < count_limit_); }
+        //Returns the lower limit of the distribution
+        uint_fast64_t lower_limit (  ) const { return min_; }
+        //Returns the upper limit of the distribution
+        uint_fast64_t upper_limit (  ) const { return max_; }
+        //Returns the alignment of the points (1 if they are not aligned)
+        uint_fast64_t alignment (  ) const { return alignment_; }
         //Returns a point the in the distribution and increments the counter
         virtual uint_fast64_t next (  ) = 0;
+        //Writes up to n next points to points and returns how many were
+        //written. Stops when the generation limit is achieved
+        virtual uint_fast64_t fill ( uint_fast64_t *points, uint_fast64_t n );
+        //Returns a vector with up to n next points
+        vector<uint_fast64_t> generate_n ( uint_fast64_t n );
 };
 
 // Distribution Generator that only provides the average point between limits
@@ -58,6 +229,8 @@ class AveragePoint : public DistributionGenerator {
         }
         //Provides the average point between lower and upper limits
         uint_fast64_t next (  );
+        //Provides the average point once
+        uint_fast64_t fill ( uint_fast64_t *points, uint_fast64_t n );
 };
 
 // Distribution Generator that splits the interval in count_limit_ + 1 parts
@@ -79,6 +252,8 @@ class UniformlySpaced : public DistributionGenerator {
         }
         //Provides the point splitting the next intervals
         uint_fast64_t next (  );
+        //Provides the points splitting the next n intervals
+        uint_fast64_t fill ( uint_fast64_t *points, uint_fast64_t n );
 };
 
 // Distribution Generator that splits the interval in count_limit + 1 parts.
@@ -87,7 +262,19 @@ class UniformlySpaced : public DistributionGenerator {
 // [2] - 3 - (4) - 5 - 6 - 7 - [8]
 // Example: ExponentiallySpaced(2,16,2) gives 4 and 8
 // [2] - 3 - (4) - 5 - 6 - 7 - (8) - 9 - 10 - 11 - 12 - 13 - 14 - 15 - [16]
+// Points above EXACT_DOUBLE_LIMIT are computed with long double, so they are
+// still integers rounded from the exact value
 class ExponentiallySpaced : public UniformlySpaced {
+    private:
+        //Min and the size of the interval in log scale
+        double log_min_, log_range_;
+        //Same values in extended precision, for intervals with large points
+        long double exact_log_min_, exact_log_range_;
+        //True if points may exceed EXACT_DOUBLE_LIMIT
+        bool exact_;
+
+        //index-th point in extended precision
+        uint_fast64_t exact_point ( uint_fast64_t index ) const;
     public:
         //Constructor with lower and upper limit and the number of parts to
         //break the space
@@ -95,9 +282,18 @@ class ExponentiallySpaced : public UniformlySpaced {
         //We only guarantee that we will not do log operations with zero
         ExponentiallySpaced (uint_fast64_t min, uint_fast64_t max,
                 uint_fast64_t count_limit) :
-            UniformlySpaced ( (min != 0ul ? min : 1ul), max, count_limit ){  }
+            UniformlySpaced ( (min != 0ul ? min : 1ul), max, count_limit ){
+            log_min_ = series_log<double> ( min_ );
+            log_range_ = series_log<double> ( max_ ) - log_min_;
+            exact_log_min_ = series_log<long double> ( min_ );
+            exact_log_range_ = series_log<long double> ( max_ ) - exact_log_min_;
+            exact_ = max_ > EXACT_DOUBLE_LIMIT;
+        }
         //Provides the point splitting the next intervals in an exponential scale
         uint_fast64_t next (  );
+        //Provides the points splitting the next n intervals in an exponential
+        //scale
+        uint_fast64_t fill ( uint_fast64_t *points, uint_fast64_t n );
 };
 
 // Distribution Generator that only provides the mid point between limits
@@ -106,55 +302,85 @@ class ExponentiallySpaced : public UniformlySpaced {
 // Example: MidPoint(2,8) gives 4
 // [2] - 3 - (4) - 5 - 6 - 7 - [8]
 class MidPoint : public AveragePoint {
+    private:
+        //Mid point, computed once since it never changes
+        uint_fast64_t point_;
     public:
         //Usual constructor with lower and upper limit
         //Limits are taken care by the factory
-        MidPoint (uint_fast64_t min, uint_fast64_t max) :
-            AveragePoint ( (min != 0ul ? min : 1ul), max ){  }
+        MidPoint (uint_fast64_t min, uint_fast64_t max);
         //Provides the mid point between lower and upper limits
         uint_fast64_t next (  );
+        //Provides the mid point once
+        uint_fast64_t fill ( uint_fast64_t *points, uint_fast64_t n );
 };
 
 // Distribution Generator that generates count_limit_ random points.
-// Example: UniformlyRandom(2,8,1) gives anything between 2 and 8 included
+// Random numbers come from Engine, which is seeded once at construction
+// Engines of 64 random bits (the default) with ranges below 2^53 map the bits
+// to points with double precision, so that fill can first draw the bits and
+// then convert them in a loop of independent iterations (vectorized by the
+// compiler). Other engines and ranges use a uniform_int_distribution
+// Example: UniformlyRandom<>(2,8,1) gives anything between 2 and 8 included
+template <typename Engine = Xoshiro256StarStar>
 class UniformlyRandom : public DistributionGenerator {
     private:
         //Uniform distribution to generate random numbers
         std::uniform_int_distribution<uint_fast64_t> randomize;
         //Generator of random numbers
-        std::random_device device;
+        Engine device;
+        //True if points are mapped from the bits with double precision
+        bool direct_;
+        //Number of points in the limits, when direct_
+        double span_;
     public:
-        //Constructor with lower and upper limit and the number of random
-        //points to generate
+        //Constructor with lower and upper limit, the number of random
+        //points to generate, and the seed of the engine
         //Limits are taken care by the factory
         UniformlyRandom (uint_fast64_t min, uint_fast64_t max,
-                uint_fast64_t count_limit) {
+                uint_fast64_t count_limit, uint_fast64_t seed = random_seed()) :
+            device ( seed ) {
             min_ = min;
             max_ = max;
             count_limit_ = count_limit;
             randomize = std::uniform_int_distribution<uint_fast64_t>(min, max);
+            direct_ = Engine::min() == 0 &&
+                Engine::max() == numeric_limits<uint64_t>::max() &&
+                max - min < EXACT_DOUBLE_LIMIT;
+            span_ = (double) ( max - min ) + 1.0;
         }
         //Provides the point splitting the next intervals in an exponential scale
         uint_fast64_t next (  );
+        //Provides the next n random points
+        uint_fast64_t fill ( uint_fast64_t *points, uint_fast64_t n );
 };
 
 // Distribution Generator that generates count_limit_ random points
 // It follows the same spacing idea of ExponentiallySpaced
-// Example: ExponentiallyRandom(2,8,4) gives 4 numbers between 2 and 8 included
+// Random numbers come from Engine, which is seeded once at construction
+// As in UniformlyRandom, engines of 64 random bits let fill draw the bits
+// first and then convert them in a loop that can be vectorized (with vector
+// versions of exp, from libmvec)
+// Example: ExponentiallyRandom<>(2,8,4) gives 4 numbers between 2 and 8 included
+template <typename Engine = Xoshiro256StarStar>
 class ExponentiallyRandom : public DistributionGenerator {
     private:
         //Uniform distribution to generate random numbers
         std::uniform_real_distribution<double> randomize;
         //Generator of random numbers
-        std::random_device device;
+        Engine device;
         //Min and Max in log scale
         double log_min_, log_max_;
+        //True if exponents are mapped from the bits directly
+        static constexpr bool direct_ = Engine::min() == 0 &&
+            Engine::max() == numeric_limits<uint64_t>::max();
     public:
-        //Constructor with lower and upper limit and the number of random
-        //points to generate
+        //Constructor with lower and upper limit, the number of random
+        //points to generate, and the seed of the engine
         //Limits are taken care by the factory
         ExponentiallyRandom (uint_fast64_t min, uint_fast64_t max,
-                uint_fast64_t count_limit) {
+                uint_fast64_t count_limit, uint_fast64_t seed = random_seed()) :
+            device ( seed ) {
             min_ = min;
             max_ = max;
             log_min_ = log (min);
@@ -164,17 +390,40 @@ class ExponentiallyRandom : public DistributionGenerator {
         }
         //Provides the point splitting the next intervals in an exponential scale
         uint_fast64_t next (  );
+        //Provides the next n random points
+        uint_fast64_t fill ( uint_fast64_t *points, uint_fast64_t n );
 
 };
 /****************************************************************************/
 // Method implementations
 
+// Names of the kinds of generators, in the order of the enum
+const char *GENERATOR_NAMES[] = { "average_point", "uniformly_spaced",
+    "exponentially_spaced", "mid_point", "uniformly_random",
+    "exponentially_random" };
+
+string generator_name ( Generators generator_kind ) {
+    return GENERATOR_NAMES[generator_kind];
+}
+
+bool generator_from_name ( const string &name, Generators &generator_kind ) {
+    for ( int kind = AVERAGE_POINT; kind <= EXPONENTIALLY_RANDOM; ++kind )
+        if ( name == GENERATOR_NAMES[kind] ) {
+            generator_kind = (Generators) kind;
+            return true;
+        }
+    return false;
+}
+
 // Second implementation: can create an Average Point or a Uniformly Spaced
 // distribution.
+// Random generators use the default engine, seeded with seed (a different
+// seed for every run if none is given)
 DistributionGenerator *DistributionGenerator::make_generator (
         uint_fast64_t min, uint_fast64_t max,
         Generators generator_kind = AVERAGE_POINT,
-        uint_fast64_t count_limit=1lu ) {
+        uint_fast64_t count_limit=1lu, uint_fast64_t seed = random_seed(),
+        uint_fast64_t alignment = 1lu ) {
     // First test: min < max -> swaps values to fix it
     if ( min > max ) swap(min, max);
     // Second test: min == max -> increases or decreases one of them
@@ -186,36 +435,102 @@ DistributionGenerator *DistributionGenerator::make_generator (
     if ( count_limit == 0 ) count_limit = 1lu;
 
     // Creates
+    DistributionGenerator *generator;
     if ( generator_kind == AVERAGE_POINT )
-        return new AveragePoint(min, max);
+        generator = new AveragePoint(min, max);
     else if ( generator_kind == UNIFORMLY_SPACED )
-        return new UniformlySpaced(min, max, count_limit);
+        generator = new UniformlySpaced(min, max, count_limit);
     else if ( generator_kind == EXPONENTIALLY_SPACED )
-        return new ExponentiallySpaced(min, max, count_limit);
+        generator = new ExponentiallySpaced(min, max, count_limit);
     else if ( generator_kind == MID_POINT )
-        return new MidPoint(min, max);
+        generator = new MidPoint(min, max);
     else if ( generator_kind == UNIFORMLY_RANDOM )
-        return new UniformlyRandom(min, max, count_limit);
+        generator = new UniformlyRandom<>(min, max, count_limit, seed);
     else
-        return new ExponentiallyRandom(min, max, count_limit);
+        generator = new ExponentiallyRandom<>(min, max, count_limit, seed);
+
+    // Aligns: the multiples are taken in the limits of the generator, which
+    // may have moved min away from 0. If the first multiple does not fit in
+    // 64 bits, first_ > last_ and points are not aligned
+    if ( alignment > 1 ) {
+        uint_fast64_t low = generator->min_, high = generator->max_;
+        uint_fast64_t up = low % alignment == 0 ? 0ul : alignment - low % alignment;
+        generator->alignment_ = alignment;
+        generator->first_ = low <= UINT_FAST64_MAX - up ? low + up : UINT_FAST64_MAX;
+        generator->last_ = high - high % alignment;
+    }
+    return generator;
+}
+
+// Bulk generation operation
+// Default implementation based on next, overridden by every generator to
+// avoid a virtual call per point
+uint_fast64_t DistributionGenerator::fill ( uint_fast64_t *points,
+        uint_fast64_t n ) {
+    n = remaining ( n );
+    for ( uint_fast64_t i = 0; i < n; ++i ) points[i] = next();
+    return n;
+}
+
+// Bulk generation into a vector
+// The vector is shrunk if fewer than n points could be generated
+vector<uint_fast64_t> DistributionGenerator::generate_n ( uint_fast64_t n ) {
+    vector<uint_fast64_t> points ( remaining ( n ) );
+    fill ( points.data(), points.size() );
+    return points;
 }
 
 
 // AveragePoint generation operation
 // Returns the average point and counts the call
-// Since we are using 64b numbers, it is not checking for overflows
 uint_fast64_t AveragePoint::next (  ) {
     ++count_;
-    return ( max_ + min_ ) >> 1;
+    return align ( average_point ( min_, max_ ) );
+}
+
+// AveragePoint bulk generation operation
+uint_fast64_t AveragePoint::fill ( uint_fast64_t *points, uint_fast64_t n ) {
+    n = remaining ( n );
+    uint_fast64_t point = align ( average_point ( min_, max_ ) );
+    for ( uint_fast64_t i = 0; i < n; ++i ) points[i] = point;
+    count_ += n;
+    return n;
 }
 
 // UniformlySpaced generation operation
 // Breaks the space in count_limit_ (+ 1) pieces, returns the n-th (count) point,
 // and counts the call
 uint_fast64_t UniformlySpaced::next (  ) {
-    uint_fast64_t point = min_ + ( count_ * ( max_ - min_ )) / count_limit_;
+    uint_fast64_t point = uniform_point ( min_, max_, count_limit_, count_ );
     ++count_;
-    return point;
+    return align ( point );
+}
+
+// UniformlySpaced bulk generation operation
+// Same points as next, but the quotient and remainder of
+// count_ * ( max_ - min_ ) / count_limit_ are updated incrementally, so there
+// is no division per point. Only the first product needs 128 bits
+uint_fast64_t UniformlySpaced::fill ( uint_fast64_t *points, uint_fast64_t n ) {
+    n = remaining ( n );
+    if ( n == 0 ) return 0;
+    const uint_fast64_t range = max_ - min_;
+    const uint_fast64_t step = range / count_limit_;
+    const uint_fast64_t step_remainder = range % count_limit_;
+    const uint_wide_t product = (uint_wide_t) count_ * range;
+    uint_fast64_t quotient = product / count_limit_;
+    uint_fast64_t remainder = product % count_limit_;
+    for ( uint_fast64_t i = 0; i < n; ++i ) {
+        points[i] = min_ + quotient;
+        quotient += step;
+        remainder += step_remainder;
+        if ( remainder >= count_limit_ ) {
+            ++quotient;
+            remainder -= count_limit_;
+        }
+    }
+    align ( points, n );
+    count_ += n;
+    return n;
 }
 
 // ExponentiallySpaced generation operation
@@ -223,36 +538,133 @@ uint_fast64_t UniformlySpaced::next (  ) {
 // an exponential scale
 // and counts the call
 uint_fast64_t ExponentiallySpaced::next (  ) {
-    double log_min = log ( min_ );
-    double log_max = log ( max_ );
-    double point = exp ( log_min + (count_ * ( log_max - log_min ) ) / count_limit_ );
+    if ( exact_ ) return align ( exact_point ( count_++ ) );
+    uint_fast64_t point = exponential_point ( exponential_exponent ( log_min_,
+                log_range_, count_limit_, count_ ), min_, max_ );
     ++count_;
-    return (uint_fast64_t) round ( point ); // Handling any rounding errors
+    return align ( point );
 }
 
-// MidPoint generation operation
+// ExponentiallySpaced bulk generation operation
+// Same computation as next, without a virtual call per point
+uint_fast64_t ExponentiallySpaced::fill ( uint_fast64_t *points,
+        uint_fast64_t n ) {
+    n = remaining ( n );
+    if ( exact_ ) {
+        for ( uint_fast64_t i = 0; i < n; ++i ) points[i] = exact_point ( count_ + i );
+    } else {
+        for ( uint_fast64_t i = 0; i < n; ++i )
+            points[i] = exponential_point ( exponential_exponent ( log_min_,
+                        log_range_, count_limit_, count_ + i ), min_, max_ );
+    }
+    align ( points, n );
+    count_ += n;
+    return n;
+}
+
+// ExponentiallySpaced extended precision operation
+uint_fast64_t ExponentiallySpaced::exact_point ( uint_fast64_t index ) const {
+    return exponential_point ( exponential_exponent ( exact_log_min_,
+                exact_log_range_, count_limit_, index ), min_, max_ );
+}
+
+// MidPoint constructor
 // Divides the interval into two parts in an exponential scale
-// and counts the call
+// Large limits use extended precision, as in ExponentiallySpaced
+MidPoint::MidPoint (uint_fast64_t min, uint_fast64_t max) :
+    AveragePoint ( (min != 0ul ? min : 1ul), max ) {
+    if ( max_ > EXACT_DOUBLE_LIMIT ) {
+        long double log_min = series_log<long double> ( min_ );
+        long double log_max = series_log<long double> ( max_ );
+        point_ = exponential_point ( exponential_exponent ( log_min,
+                    log_max - log_min, 2ul, 1ul ), min_, max_ );
+        return;
+    }
+    double log_min = series_log<double> ( min_ );
+    double log_max = series_log<double> ( max_ );
+    point_ = exponential_point ( exponential_exponent ( log_min, log_max - log_min,
+                2ul, 1ul ), min_, max_ );
+}
+
+// MidPoint generation operation
+// Returns the point computed by the constructor and counts the call
 uint_fast64_t MidPoint::next (  ) {
-    double log_min = log ( min_ );
-    double log_max = log ( max_ );
-    double point = exp ( log_min + ( log_max - log_min ) / 2 );
     ++count_;
-    return (uint_fast64_t) round ( point ); // Handling any rounding errors
+    return align ( point_ );
+}
+
+// MidPoint bulk generation operation
+uint_fast64_t MidPoint::fill ( uint_fast64_t *points, uint_fast64_t n ) {
+    n = remaining ( n );
+    uint_fast64_t point = align ( point_ );
+    for ( uint_fast64_t i = 0; i < n; ++i ) points[i] = point;
+    count_ += n;
+    return n;
 }
 
 // UniformlyRandom generation operation
-// Gets a number in a uniform_int_distribution
-uint_fast64_t UniformlyRandom::next (  ) {
+// Gets a number in a uniform_int_distribution, or maps the bits of the engine
+// to the limits as fill does
+template <typename Engine>
+uint_fast64_t UniformlyRandom<Engine>::next (  ) {
     ++count_;
-    return randomize ( device );
+    if ( ! direct_ ) return align ( randomize ( device ) );
+    uint_fast64_t point = min_ + (uint_fast64_t) ( unit_interval ( device() ) * span_ );
+    return align ( point < max_ ? point : max_ );
+}
+
+// UniformlyRandom bulk generation operation
+// The engine is sequential, so the bits are drawn first and converted to
+// points in a second loop whose iterations are independent
+template <typename Engine>
+uint_fast64_t UniformlyRandom<Engine>::fill ( uint_fast64_t *points,
+        uint_fast64_t n ) {
+    n = remaining ( n );
+    if ( direct_ ) {
+        for ( uint_fast64_t i = 0; i < n; ++i ) points[i] = device();
+        const uint_fast64_t min = min_, max = max_;
+        const double span = span_;
+        for ( uint_fast64_t i = 0; i < n; ++i ) {
+            uint_fast64_t point = min + (uint_fast64_t) ( unit_interval ( points[i] ) * span );
+            points[i] = point < max ? point : max;
+        }
+    } else {
+        for ( uint_fast64_t i = 0; i < n; ++i ) points[i] = randomize ( device );
+    }
+    align ( points, n );
+    count_ += n;
+    return n;
 }
 
 // ExponentiallyRandom generation operation
-// Gets a number in a uniform_real_distribution and converts it to a point in
-// the original limits
-uint_fast64_t ExponentiallyRandom::next (  ) {
+// Gets a number in a uniform_real_distribution, or maps the bits of the engine
+// as fill does, and converts it to a point in the original limits
+template <typename Engine>
+uint_fast64_t ExponentiallyRandom<Engine>::next (  ) {
     ++count_;
-    return exp ( randomize ( device ) );
+    if ( ! direct_ ) return align ( exp ( randomize ( device ) ) );
+    return align ( (uint_fast64_t) exp ( log_min_ +
+                unit_interval ( device() ) * ( log_max_ - log_min_ ) ) );
 }
 
+// ExponentiallyRandom bulk generation operation
+// Same two loops as UniformlyRandom::fill
+template <typename Engine>
+uint_fast64_t ExponentiallyRandom<Engine>::fill ( uint_fast64_t *points,
+        uint_fast64_t n ) {
+    n = remaining ( n );
+    if ( direct_ ) {
+        for ( uint_fast64_t i = 0; i < n; ++i ) points[i] = device();
+        const double log_min = log_min_;
+        const double log_range = log_max_ - log_min_;
+        for ( uint_fast64_t i = 0; i < n; ++i )
+            points[i] = (uint_fast64_t) exp ( log_min +
+                    unit_interval ( points[i] ) * log_range );
+    } else {
+        for ( uint_fast64_t i = 0; i < n; ++i )
+            points[i] = (uint_fast64_t) exp ( randomize ( device ) );
+    }
+    align ( points, n );
+    count_ += n;
+    return n;
+}
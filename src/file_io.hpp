@@ -0,0 +1,404 @@
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "buffer_arena.hpp"
+#include "distribution_generator.hpp"
+
+using namespace std;
+
+// Classes in this file
+class FileIo;
+
+// Ways of reading a file
+enum FileAccess {
+    MMAP_READ,          // Loads from a mapping of the file
+    MMAP_SEQUENTIAL,    // Same, after madvise(MADV_SEQUENTIAL)
+    MMAP_WILLNEED,      // Same, after madvise(MADV_WILLNEED)
+    READ_CALL,          // read() of blocks into a buffer
+    PREAD_CALL          // pread() of blocks at explicit offsets
+};
+
+// State of the page cache when a read starts
+enum CacheState {
+    COLD_CACHE,         // Pages of the file evicted from the page cache
+    WARM_CACHE          // Pages of the file in the page cache
+};
+
+// Memory whose page faults are measured
+enum FaultTarget {
+    ANONYMOUS_MEMORY,   // New anonymous memory (a BufferArena)
+    MAPPED_FILE         // A MAP_SHARED mapping of the file, in the page cache
+};
+
+// Bandwidth of reading the first size bytes of a file
+struct FileIoPoint {
+    uint_fast64_t size;     //Bytes read
+    FileAccess access;      //How they were read
+    CacheState cache;       //Requested page cache state
+    double resident;        //Fraction of the pages in the page cache before
+                            //the first timed read (what cold actually got)
+    double gb_per_s;        //Bytes read per second (10^9 B/s), including
+                            //mapping and system calls
+};
+
+// Cost of the page faults of touching new memory
+struct PageFaultPoint {
+    uint_fast64_t size;     //Bytes touched
+    FaultTarget target;     //Memory touched
+    PageKind kind;          //Kind of page obtained
+    uint_fast64_t page_size;
+    double ns_per_fault;    //Time per page, including zeroing it
+};
+
+// Returns the name of a way of reading a file
+string file_access_name ( FileAccess access );
+// Returns the name of a page cache state ("cold" or "warm")
+string cache_state_name ( CacheState cache );
+// Returns the name of a fault target ("anon" or "file")
+string fault_target_name ( FaultTarget target );
+
+/****************************************************************************/
+// File read bandwidth through the page cache, and page fault costs.
+// Measurements read the start of a temporary file, which is created in a
+// directory (TMPDIR or /tmp by default), unlinked at once, and written with
+// data (not extended with holes, which read as zero pages without I/O).
+// Cold reads first write back and evict the pages of the file with
+// posix_fadvise(POSIX_FADV_DONTNEED), which needs no privileges; on tmpfs
+// pages cannot be evicted, and resident tells how cold a read really was.
+// Warm reads follow an untimed read of the same bytes. Mapped reads sum
+// every word, so they include mapping, faults and unmapping; read and pread
+// copy blocks into a buffer.
+// Page faults of anonymous memory are measured as the time to map and
+// pre-fault a BufferArena of each kind of page (BufferArena::fault_ns),
+// divided by its number of pages. Page faults of the file are measured as the time to map the start
+// of the file with MAP_SHARED and read one word of every page, after an
+// untimed read put it in the page cache, so they include no I/O. Read
+// faults of small pages also map cached neighbours (fault-around), as they
+// do for any reader of a mapped file. Huge pages of a file need a file
+// system with large folios (or tmpfs with huge pages) and THP allowed for
+// files: the mapping is aligned and advised with MADV_HUGEPAGE, its page
+// cache is rebuilt through it, and the point reports base pages unless
+// most of it was mapped with PMDs (FilePmdMapped or ShmemPmdMapped).
+// Example of use:
+//   DistributionGenerator *generator = DistributionGenerator::make_generator(
+//       4096, 1ul<<30, EXPONENTIALLY_SPACED, 16);
+//   FileIo io;
+//   for ( FileIoPoint &point : io.sweep(generator) )
+//       std::cout << point.size << " " << file_access_name(point.access) << " "
+//           << cache_state_name(point.cache) << " " << point.gb_per_s << std::endl;
+class FileIo {
+    private:
+        int file_ = -1;                 //Descriptor of the unlinked file
+        uint_fast64_t file_size_ = 0;   //Bytes written to the file
+        uint_fast64_t traffic_;         //Minimum bytes read per warm measurement
+        uint_fast64_t block_;           //Bytes per read and pread call
+        char *buffer_ = nullptr;        //Destination of read and pread
+
+        //Writes back and evicts the pages of the file
+        void evict (  );
+        //Fraction of the first size bytes in the page cache (mincore)
+        double resident ( uint_fast64_t size );
+        //Reads size bytes once, returning a sum of the words read
+        uint64_t read_once ( FileAccess access, uint_fast64_t size );
+        //Maps size bytes of the file at an address aligned to alignment,
+        //advised for a kind of page, or returns nullptr
+        char *map_aligned ( uint_fast64_t size, uint_fast64_t alignment,
+                PageKind kind );
+        //Measures the page faults of a mapping of size bytes of the file
+        PageFaultPoint file_faults ( PageKind kind, uint_fast64_t size );
+
+    public:
+        //Constructor with the directory of the file, the minimum number of
+        //bytes read by each warm measurement, and the size of read calls
+        FileIo ( const string &directory = "", uint_fast64_t traffic = 1ul << 28,
+                uint_fast64_t block = 1ul << 20 );
+        ~FileIo (  );
+        FileIo ( const FileIo & ) = delete;
+        FileIo &operator= ( const FileIo & ) = delete;
+
+        //Grows the file to at least size bytes
+        void reserve ( uint_fast64_t size );
+        //Device of the file system holding the file (st_dev)
+        uint_fast64_t device (  ) const;
+        //Measures reading size bytes in one way (in GB/s)
+        FileIoPoint measure ( FileAccess access, CacheState cache, uint_fast64_t size );
+        //Measures the page faults of size bytes of new memory or of the file
+        PageFaultPoint measure_faults ( PageKind kind, uint_fast64_t size,
+                FaultTarget target = ANONYMOUS_MEMORY );
+        //Measures every size provided by the generator for each way of
+        //reading and each page cache state
+        vector<FileIoPoint> sweep ( DistributionGenerator *generator,
+                const vector<FileAccess> &accesses = { MMAP_READ, MMAP_SEQUENTIAL,
+                    MMAP_WILLNEED, READ_CALL, PREAD_CALL },
+                const vector<CacheState> &caches = { COLD_CACHE, WARM_CACHE } );
+        //Measures the page faults of every size provided by the generator for
+        //each target and each kind of page. hugetlbfs pages cannot back the
+        //file, so its faults skip HUGE_2M and HUGE_1G
+        vector<PageFaultPoint> fault_sweep ( DistributionGenerator *generator,
+                const vector<PageKind> &kinds = { SMALL_PAGES, TRANSPARENT_HUGE,
+                    HUGE_2M },
+                const vector<FaultTarget> &targets = { ANONYMOUS_MEMORY, MAPPED_FILE } );
+};
+
+/****************************************************************************/
+// Method implementations
+
+string file_access_name ( FileAccess access ) {
+    if ( access == MMAP_READ ) return "mmap";
+    else if ( access == MMAP_SEQUENTIAL ) return "mmap_sequential";
+    else if ( access == MMAP_WILLNEED ) return "mmap_willneed";
+    else if ( access == READ_CALL ) return "read";
+    else return "pread";
+}
+
+string cache_state_name ( CacheState cache ) {
+    if ( cache == COLD_CACHE ) return "cold";
+    else return "warm";
+}
+
+string fault_target_name ( FaultTarget target ) {
+    if ( target == ANONYMOUS_MEMORY ) return "anon";
+    else return "file";
+}
+
+// Cold reads repeat the eviction for every pass, so they use few passes
+const uint_fast64_t COLD_REPETITIONS = 8ul;
+
+// File creation
+// The file is unlinked at once, so it disappears even if the program dies
+FileIo::FileIo ( const string &directory, uint_fast64_t traffic,
+        uint_fast64_t block ) :
+    traffic_ ( traffic ),
+    block_ ( max(block, (uint_fast64_t) 4096ul) & ~(uint_fast64_t) 4095ul ) {
+    string path = directory;
+    if ( path.empty() ) path = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+    path += "/topoperf_io_XXXXXX";
+    vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+    file_ = mkstemp(name.data());
+    if ( file_ < 0 ) throw runtime_error("cannot create a file in " + path);
+    unlink(name.data());
+    void *memory = nullptr;
+    if ( posix_memalign(&memory, 4096, block_) != 0 ) {
+        close(file_);
+        throw bad_alloc();
+    }
+    buffer_ = static_cast<char*>(memory);
+}
+
+FileIo::~FileIo (  ) {
+    free(buffer_);
+    if ( file_ >= 0 ) close(file_);
+}
+
+// File growth
+// Blocks hold their offset, so pages have distinct contents
+void FileIo::reserve ( uint_fast64_t size ) {
+    size = ( size + 4095ul ) & ~(uint_fast64_t) 4095ul;
+    while ( file_size_ < size ) {
+        uint_fast64_t bytes = min(block_, size - file_size_);
+        uint64_t *words = (uint64_t*) buffer_;
+        for ( uint_fast64_t i = 0; i < bytes / sizeof(uint64_t); ++i )
+            words[i] = file_size_ + i;
+        ssize_t written = pwrite(file_, buffer_, bytes, file_size_);
+        if ( written <= 0 ) throw runtime_error("cannot write the test file");
+        file_size_ += written;
+    }
+}
+
+uint_fast64_t FileIo::device (  ) const {
+    struct stat status;
+    if ( fstat(file_, &status) != 0 ) throw runtime_error("cannot stat the test file");
+    return status.st_dev;
+}
+
+// Eviction
+// The whole file is evicted: the page cache may hold it in large folios,
+// and a folio crossing the end of a range is not dropped
+void FileIo::evict (  ) {
+    fdatasync(file_);
+    posix_fadvise(file_, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+double FileIo::resident ( uint_fast64_t size ) {
+    void *memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, file_, 0);
+    if ( memory == MAP_FAILED ) return 0.0;
+    uint_fast64_t base = sysconf(_SC_PAGESIZE);
+    vector<unsigned char> pages(( size + base - 1 ) / base);
+    uint_fast64_t cached = 0;
+    if ( mincore(memory, size, pages.data()) == 0 )
+        for ( unsigned char page : pages ) cached += page & 1u;
+    munmap(memory, size);
+    return (double) cached / pages.size();
+}
+
+// One pass
+// Partial blocks of read and pread are read with a shorter last call
+uint64_t FileIo::read_once ( FileAccess access, uint_fast64_t size ) {
+    uint64_t sum = 0;
+    if ( access == READ_CALL || access == PREAD_CALL ) {
+        if ( access == READ_CALL ) lseek(file_, 0, SEEK_SET);
+        for ( uint_fast64_t offset = 0; offset < size; ) {
+            uint_fast64_t bytes = min(block_, size - offset);
+            ssize_t got = access == READ_CALL ? read(file_, buffer_, bytes) :
+                pread(file_, buffer_, bytes, offset);
+            if ( got <= 0 ) throw runtime_error("cannot read the test file");
+            sum += *(uint64_t*) buffer_;
+            offset += got;
+        }
+        return sum;
+    }
+    void *memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, file_, 0);
+    if ( memory == MAP_FAILED ) throw runtime_error("cannot map the test file");
+    if ( access == MMAP_SEQUENTIAL ) madvise(memory, size, MADV_SEQUENTIAL);
+    if ( access == MMAP_WILLNEED ) madvise(memory, size, MADV_WILLNEED);
+    const uint64_t *words = (const uint64_t*) memory;
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    uint_fast64_t n = size / sizeof(uint64_t), i = 0;
+    for ( ; i + 4 <= n; i += 4 ) {
+        s0 += words[i];     s1 += words[i + 1];
+        s2 += words[i + 2]; s3 += words[i + 3];
+    }
+    for ( ; i < n; ++i ) s0 += words[i];
+    munmap(memory, size);
+    return s0 + s1 + s2 + s3;
+}
+
+// Read measurement
+// Sizes are rounded up to whole pages. Evictions of cold passes are not
+// timed
+FileIoPoint FileIo::measure ( FileAccess access, CacheState cache,
+        uint_fast64_t size ) {
+    size = max(( size + 4095ul ) & ~(uint_fast64_t) 4095ul, (uint_fast64_t) 4096ul);
+    reserve(size);
+    uint_fast64_t repetitions = max(traffic_ / size, (uint_fast64_t) 1ul);
+    if ( cache == COLD_CACHE ) repetitions = min(repetitions, COLD_REPETITIONS);
+
+    volatile uint64_t sink = 0;
+    if ( cache == WARM_CACHE ) sink = sink + read_once(READ_CALL, size);
+    double ns = 0.0, cached = 0.0;
+    for ( uint_fast64_t r = 0; r < repetitions; ++r ) {
+        if ( cache == COLD_CACHE ) evict();
+        if ( r == 0 ) cached = resident(size);
+        auto begin = chrono::steady_clock::now();
+        sink = sink + read_once(access, size);
+        auto finish = chrono::steady_clock::now();
+        ns += chrono::duration<double, nano>(finish - begin).count();
+    }
+    return { size, access, cache, cached,
+        (double) size * repetitions / ns };
+}
+
+// Page fault measurement
+// The arena falls back to smaller pages when a kind is not available, so
+// the point has the kind that was obtained
+PageFaultPoint FileIo::measure_faults ( PageKind kind, uint_fast64_t size,
+        FaultTarget target ) {
+    if ( target == MAPPED_FILE ) return file_faults(kind, size);
+    BufferArena arena(size, kind);
+    uint_fast64_t pages = arena.size() / arena.page_size();
+    return { arena.size(), ANONYMOUS_MEMORY, arena.page_kind(), arena.page_size(),
+        arena.fault_ns() / pages };
+}
+
+// Aligned mapping of the file
+// An anonymous reservation one alignment larger is replaced by the file
+// mapping at its first aligned address, and the rest is released
+char *FileIo::map_aligned ( uint_fast64_t size, uint_fast64_t alignment,
+        PageKind kind ) {
+    uint_fast64_t span = size + alignment;
+    void *reserved = mmap(nullptr, span, PROT_NONE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if ( reserved == MAP_FAILED ) return nullptr;
+    uintptr_t start = (uintptr_t) reserved;
+    uintptr_t aligned = ( start + alignment - 1 ) & ~(uintptr_t) ( alignment - 1 );
+    if ( aligned > start ) munmap(reserved, aligned - start);
+    munmap((void*) ( aligned + size ), start + span - aligned - size);
+    void *memory = mmap((void*) aligned, size, PROT_READ, MAP_SHARED | MAP_FIXED,
+            file_, 0);
+    if ( memory == MAP_FAILED ) {
+        munmap((void*) aligned, size);
+        return nullptr;
+    }
+    madvise(memory, size, kind == SMALL_PAGES ? MADV_NOHUGEPAGE : MADV_HUGEPAGE);
+    return static_cast<char*>(memory);
+}
+
+// File page fault measurement
+// The page cache of a huge page mapping is rebuilt through an untimed
+// mapping with the same advice, since pages read by read() are cached in
+// small folios. Only the mapping and the faults are timed
+PageFaultPoint FileIo::file_faults ( PageKind kind, uint_fast64_t size ) {
+    uint_fast64_t base = sysconf(_SC_PAGESIZE), huge = 1ul << 21;
+    if ( kind != SMALL_PAGES ) kind = TRANSPARENT_HUGE;
+    uint_fast64_t alignment = kind == SMALL_PAGES ? base : huge;
+    size = max(( size + base - 1 ) & ~( base - 1 ), base);
+    reserve(size);
+
+    volatile uint64_t sink = 0;
+    if ( kind == SMALL_PAGES ) sink = sink + read_once(READ_CALL, size);
+    else {
+        evict();
+        char *warm = map_aligned(size, alignment, kind);
+        if ( ! warm ) throw runtime_error("cannot map the test file");
+        for ( uint_fast64_t offset = 0; offset < size; offset += base )
+            sink = sink + *(const uint64_t*) ( warm + offset );
+        munmap(warm, size);
+    }
+
+    auto begin = chrono::steady_clock::now();
+    char *memory = map_aligned(size, alignment, kind);
+    if ( memory )
+        for ( uint_fast64_t offset = 0; offset < size; offset += base )
+            sink = sink + *(const uint64_t*) ( memory + offset );
+    auto finish = chrono::steady_clock::now();
+    if ( ! memory ) throw runtime_error("cannot map the test file");
+
+    uint_fast64_t mapped = BufferArena::huge_bytes(memory, "FilePmdMapped") +
+        BufferArena::huge_bytes(memory, "ShmemPmdMapped");
+    munmap(memory, size);
+    if ( kind == TRANSPARENT_HUGE && 2ul * mapped < size ) kind = SMALL_PAGES;
+    uint_fast64_t page = kind == SMALL_PAGES ? base : huge;
+    uint_fast64_t pages = max(size / page, (uint_fast64_t) 1ul);
+    return { size, MAPPED_FILE, kind, page,
+        chrono::duration<double, nano>(finish - begin).count() / pages };
+}
+
+vector<FileIoPoint> FileIo::sweep ( DistributionGenerator *generator,
+        const vector<FileAccess> &accesses, const vector<CacheState> &caches ) {
+    vector<uint_fast64_t> sizes;
+    while ( ! generator->is_done() ) sizes.push_back(generator->next());
+    if ( ! sizes.empty() ) reserve(*max_element(sizes.begin(), sizes.end()));
+
+    vector<FileIoPoint> points;
+    for ( uint_fast64_t size : sizes )
+        for ( CacheState cache : caches )
+            for ( FileAccess access : accesses )
+                points.push_back(measure(access, cache, size));
+    return points;
+}
+
+vector<PageFaultPoint> FileIo::fault_sweep ( DistributionGenerator *generator,
+        const vector<PageKind> &kinds, const vector<FaultTarget> &targets ) {
+    vector<PageFaultPoint> points;
+    while ( ! generator->is_done() ) {
+        uint_fast64_t size = generator->next();
+        for ( FaultTarget target : targets )
+            for ( PageKind kind : kinds )
+                if ( target == ANONYMOUS_MEMORY || kind == SMALL_PAGES ||
+                        kind == TRANSPARENT_HUGE )
+                    points.push_back(measure_faults(kind, size, target));
+    }
+    return points;
+}
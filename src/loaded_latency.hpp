@@ -0,0 +1,222 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "bandwidth.hpp"
+#include "distribution_generator.hpp"
+#include "pointer_chase.hpp"
+#include "threading.hpp"
+#include "topology.hpp"
+
+using namespace std;
+
+// Classes in this file
+class LoadedLatency;
+
+// Latency measured for one chase size and one traffic intensity
+struct LoadedLatencyPoint {
+    int node;                   //Memory node of the chase and the traffic
+    uint_fast64_t size;         //Size of the chase buffer in bytes
+    uint_fast64_t delay;        //Delay between traffic blocks (idle: 0)
+    unsigned traffic_threads;   //Threads generating traffic (idle: 0)
+    double ns_per_load;         //Average time of one dependent load
+    double gb_per_s;            //Traffic bandwidth during the chase (10^9 B/s)
+};
+
+// Bytes of each traffic block, between two delays
+const uint_fast64_t TRAFFIC_BLOCK = 64ul * 1024ul;
+
+/****************************************************************************/
+// Latency under concurrent bandwidth pressure.
+// One thread runs a pointer chase while the other threads stream a bandwidth
+// kernel over their own arrays, all of them on the CPUs and the memory of a
+// NUMA node. Traffic threads wait a delay (in busy loop iterations) after
+// each block of TRAFFIC_BLOCK bytes, so each delay is one step of intensity,
+// from 0 (as much traffic as possible) to large delays (almost idle). The
+// bandwidth actually generated during each chase is measured as well, giving
+// a latency vs bandwidth curve. The first point of each size is the idle
+// latency, with the traffic threads paused.
+// Example of use:
+//   DistributionGenerator *generator = DistributionGenerator::make_generator(
+//       1ul<<20, 1ul<<30, EXPONENTIALLY_SPACED, 4);
+//   LoadedLatency loaded(7, READ);
+//   for ( LoadedLatencyPoint &point : loaded.sweep(generator) )
+//       std::cout << point.node << " " << point.gb_per_s << " "
+//           << point.ns_per_load << std::endl;
+class LoadedLatency {
+    private:
+        Topology topology_;             //Source of the CPUs of each node
+        unsigned traffic_threads_;      //Threads generating traffic
+        BandwidthKernel kernel_;        //Kernel of the traffic
+        BandwidthKernels kernels_;      //Kernels for the best ISA
+        uint_fast64_t traffic_size_;    //Bytes of each traffic array
+        vector<uint_fast64_t> delays_;  //Intensity steps
+        uint_fast64_t loads_;           //Timed loads of the chase
+
+        //Streams the traffic kernel until stop is set. It pauses while
+        //delay is PAUSED and adds the bytes it moves to bytes
+        void traffic ( int cpu, int node, const atomic<uint_fast64_t> &delay,
+                const atomic<bool> &stop, atomic<uint_fast64_t> &bytes );
+        //Waits until the traffic threads move data after leaving the pause
+        void settle ( const atomic<uint_fast64_t> &bytes ) const;
+
+    public:
+        //Delay value of paused traffic threads
+        static const uint_fast64_t PAUSED = UINT_FAST64_MAX;
+
+        //Constructor with the number of traffic threads, the traffic kernel,
+        //the delays of each intensity step, the size of the arrays of each
+        //traffic thread and the number of timed loads of the chase
+        LoadedLatency ( unsigned traffic_threads =
+                    max(thread::hardware_concurrency(), 2u) - 1u,
+                BandwidthKernel kernel = READ,
+                vector<uint_fast64_t> delays =
+                    { 0ul, 256ul, 1024ul, 4096ul, 16384ul, 65536ul },
+                uint_fast64_t traffic_size = 1ul << 26,
+                uint_fast64_t loads = 1ul << 20,
+                const Topology &topology = Topology::discover() );
+
+        //Measures every size of a list with every intensity on a node
+        vector<LoadedLatencyPoint> measure ( int node,
+                const vector<uint_fast64_t> &sizes );
+        //Measures every size of a list with every intensity on every node
+        vector<LoadedLatencyPoint> sweep ( const vector<uint_fast64_t> &sizes );
+        //Measures every size provided by the generator on every node
+        vector<LoadedLatencyPoint> sweep ( DistributionGenerator *generator );
+};
+
+/****************************************************************************/
+// Method implementations
+
+LoadedLatency::LoadedLatency ( unsigned traffic_threads, BandwidthKernel kernel,
+        vector<uint_fast64_t> delays, uint_fast64_t traffic_size,
+        uint_fast64_t loads, const Topology &topology ) :
+    topology_ ( topology ), traffic_threads_ ( traffic_threads ),
+    kernel_ ( kernel ), kernels_ ( kernels_for(best_vector_isa()) ),
+    traffic_size_ ( ( max(traffic_size, TRAFFIC_BLOCK) + TRAFFIC_BLOCK - 1 ) /
+            TRAFFIC_BLOCK * TRAFFIC_BLOCK ),
+    delays_ ( delays ), loads_ ( loads ) {  }
+
+// Traffic generation
+// Arrays are allocated and first touched after the memory policy of the
+// thread is bound to the node (a thread that cannot allocate them generates
+// no traffic). The delay is a busy loop, so that the core stays active like
+// in a loaded server
+void LoadedLatency::traffic ( int cpu, int node,
+        const atomic<uint_fast64_t> &delay, const atomic<bool> &stop,
+        atomic<uint_fast64_t> &bytes ) {
+    pin_current_thread(cpu);
+    bind_thread_memory(node);
+    uint_fast64_t n = traffic_size_ / sizeof(double);
+    double *arrays[3] = { nullptr, nullptr, nullptr };
+    bool allocated = true;
+    for ( double *&array : arrays ) {
+        void *memory = nullptr;
+        allocated = allocated && posix_memalign(&memory, 4096, traffic_size_) == 0;
+        array = static_cast<double*>(memory);
+        if ( allocated ) kernels_.write(array, 1.0, n);
+    }
+
+    uint_fast64_t block = TRAFFIC_BLOCK / sizeof(double);
+    uint_fast64_t block_bytes = kernel_bytes(kernel_, block);
+    volatile double sink = 0.0;
+    uint_fast64_t offset = 0;
+    while ( allocated && ! stop.load(memory_order_relaxed) ) {
+        uint_fast64_t wait = delay.load(memory_order_relaxed);
+        if ( wait == PAUSED ) { this_thread::yield(); continue; }
+        double *a = arrays[0] + offset, *b = arrays[1] + offset,
+               *c = arrays[2] + offset;
+        if ( kernel_ == READ ) sink = sink + kernels_.read(a, block);
+        else if ( kernel_ == WRITE ) kernels_.write(a, 2.0, block);
+        else if ( kernel_ == COPY ) kernels_.copy(a, b, block);
+        else if ( kernel_ == TRIAD ) kernels_.triad(a, b, c, 3.0, block);
+        else if ( kernel_ == RMW ) kernels_.rmw(a, 1.0, block);
+        else if ( kernel_ == STREAM_WRITE ) kernels_.stream_write(a, 2.0, block);
+        else kernels_.stream_copy(a, b, block);
+        bytes.fetch_add(block_bytes, memory_order_relaxed);
+        offset = offset + block < n ? offset + block : 0;
+        for ( volatile uint_fast64_t i = 0; i < wait; i = i + 1 );
+    }
+    for ( double *array : arrays ) free(array);
+}
+
+// Traffic start
+// Gives up after 100 ms, in case no traffic thread could allocate its arrays
+void LoadedLatency::settle ( const atomic<uint_fast64_t> &bytes ) const {
+    if ( traffic_threads_ == 0 ) return;
+    uint_fast64_t before = bytes.load(memory_order_relaxed);
+    auto limit = chrono::steady_clock::now() + chrono::milliseconds(100);
+    while ( bytes.load(memory_order_relaxed) == before &&
+            chrono::steady_clock::now() < limit )
+        this_thread::yield();
+}
+
+// Loaded measurement of one node
+// The chase runs in a thread placed on the first CPU of the node, and the
+// traffic threads use the other CPUs of the node (round robin, sharing the
+// CPUs when there are more threads than CPUs). Bandwidth is the traffic
+// counted between the start and the end of each chase
+vector<LoadedLatencyPoint> LoadedLatency::measure ( int node,
+        const vector<uint_fast64_t> &sizes ) {
+    vector<int> cpus = topology_.cpus_of_node(node);
+    if ( cpus.empty() ) cpus = allowed_cpus();
+    vector<LoadedLatencyPoint> points;
+
+    run_placed( { cpus.front(), node }, [&] (  ) {
+        PointerChase chase(64ul, loads_);
+        atomic<uint_fast64_t> delay(PAUSED);
+        atomic<bool> stop(false);
+        atomic<uint_fast64_t> bytes(0);
+        vector<thread> workers;
+        for ( unsigned t = 0; t < traffic_threads_; ++t ) {
+            int cpu = cpus.size() > 1 ? cpus[1 + t % ( cpus.size() - 1 )] :
+                cpus.front();
+            workers.emplace_back( [&, cpu] (  ) {
+                traffic(cpu, node, delay, stop, bytes);
+            } );
+        }
+
+        for ( uint_fast64_t size : sizes ) {
+            chase.prepare(size);
+            points.push_back( { node, size, 0ul, 0u, chase.measure(), 0.0 } );
+            for ( uint_fast64_t step : delays_ ) {
+                delay.store(step, memory_order_relaxed);
+                settle(bytes);
+                uint_fast64_t before = bytes.load(memory_order_relaxed);
+                auto begin = chrono::steady_clock::now();
+                double latency = chase.measure();
+                auto finish = chrono::steady_clock::now();
+                uint_fast64_t moved = bytes.load(memory_order_relaxed) - before;
+                delay.store(PAUSED, memory_order_relaxed);
+                double ns = chrono::duration<double, nano>(finish - begin).count();
+                points.push_back( { node, size, step, traffic_threads_,
+                        latency, moved / ns } );
+            }
+        }
+
+        stop.store(true, memory_order_relaxed);
+        for ( thread &worker : workers ) worker.join();
+    } );
+    return points;
+}
+
+vector<LoadedLatencyPoint> LoadedLatency::sweep (
+        const vector<uint_fast64_t> &sizes ) {
+    vector<LoadedLatencyPoint> points;
+    for ( int node : topology_.nodes() ) {
+        vector<LoadedLatencyPoint> node_points = measure(node, sizes);
+        points.insert(points.end(), node_points.begin(), node_points.end());
+    }
+    return points;
+}
+
+vector<LoadedLatencyPoint> LoadedLatency::sweep (
+        DistributionGenerator *generator ) {
+    vector<uint_fast64_t> sizes;
+    while ( ! generator->is_done() ) sizes.push_back(generator->next());
+    return sweep(sizes);
+}
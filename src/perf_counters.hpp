@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define TOPOPERF_PERF 1
+#endif
+
+using namespace std;
+
+// Classes in this file
+class PerfCounters;
+
+// Hardware events counted around measurements
+enum CounterEvent {
+    CYCLES,         // Core cycles
+    INSTRUCTIONS,   // Retired instructions
+    L1D_MISSES,     // L1 data cache read misses
+    LLC_MISSES,     // Last level cache read misses
+    DTLB_MISSES,    // Data TLB read misses
+    PREFETCHES      // L1 data cache prefetch requests
+};
+
+// Number of kinds of CounterEvent
+const unsigned COUNTER_EVENTS = 6u;
+
+// Counter deltas of one measurement. Values of events that could not be
+// counted are 0 and marked as not available
+struct CounterValues {
+    double values[COUNTER_EVENTS] = {  };
+    bool available[COUNTER_EVENTS] = {  };
+
+    //Value of an event
+    double operator[] ( CounterEvent event ) const { return values[event]; }
+    //True if at least one event was counted
+    bool any (  ) const;
+    //Values divided by a number of operations (e.g. to get misses per load)
+    CounterValues per ( double operations ) const;
+};
+
+// Returns the name of an event (e.g. "l1d_misses")
+string counter_name ( CounterEvent event );
+
+/****************************************************************************/
+// Group of hardware counters of the calling thread, read with perf_event_open.
+// All events are opened in one group, so they are enabled, disabled and read
+// together with one system call each, and they count the same instructions.
+// Only user space is counted, which is allowed with perf_event_paranoid up
+// to 2. Events the kernel or the CPU do not support are left out of the
+// group, and without any of them (e.g. in a virtual machine without a PMU)
+// start and stop do nothing and every value is marked as not available.
+// When the kernel multiplexes the group, values are scaled by the fraction
+// of time it was running.
+// Example of use:
+//   PerfCounters counters;
+//   counters.start();
+//   chase.traverse();
+//   CounterValues misses = counters.stop().per(chase.loads());
+//   if ( misses.available[DTLB_MISSES] )
+//       std::cout << misses[DTLB_MISSES] << " dTLB misses per load" << std::endl;
+class PerfCounters {
+    private:
+        int leader_ = -1;               //File descriptor of the group leader
+        vector<int> descriptors_;       //File descriptors of the group
+        vector<CounterEvent> events_;   //Event of each descriptor
+
+        //Opens one event in the group. Returns -1 if it is not supported
+        int open ( CounterEvent event );
+
+    public:
+        //Constructor with the events to count (all of them by default)
+        PerfCounters ( const vector<CounterEvent> &events =
+                { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, DTLB_MISSES,
+                  PREFETCHES } );
+        ~PerfCounters (  );
+        PerfCounters ( const PerfCounters & ) = delete;
+        PerfCounters &operator= ( const PerfCounters & ) = delete;
+
+        //True if at least one event can be counted
+        bool available (  ) const { return leader_ >= 0; }
+        //True if an event is part of the group
+        bool available ( CounterEvent event ) const;
+        //Resets and enables the group
+        void start (  );
+        //Disables the group without reading it, so that only parts of the
+        //work between start and stop are counted
+        void pause (  );
+        //Enables the group again after pause, keeping its counts
+        void resume (  );
+        //Disables the group and returns the counts since start
+        CounterValues stop (  );
+};
+
+/****************************************************************************/
+// Method implementations
+
+bool CounterValues::any (  ) const {
+    for ( bool counted : available ) if ( counted ) return true;
+    return false;
+}
+
+CounterValues CounterValues::per ( double operations ) const {
+    CounterValues result = *this;
+    if ( operations > 0.0 )
+        for ( double &value : result.values ) value /= operations;
+    return result;
+}
+
+string counter_name ( CounterEvent event ) {
+    if ( event == CYCLES ) return "cycles";
+    else if ( event == INSTRUCTIONS ) return "instructions";
+    else if ( event == L1D_MISSES ) return "l1d_misses";
+    else if ( event == LLC_MISSES ) return "llc_misses";
+    else if ( event == DTLB_MISSES ) return "dtlb_misses";
+    else return "prefetches";
+}
+
+PerfCounters::PerfCounters ( const vector<CounterEvent> &events ) {
+    for ( CounterEvent event : events ) {
+        int descriptor = open(event);
+        if ( descriptor < 0 ) continue;
+        if ( leader_ < 0 ) leader_ = descriptor;
+        descriptors_.push_back(descriptor);
+        events_.push_back(event);
+    }
+}
+
+PerfCounters::~PerfCounters (  ) {
+#ifdef TOPOPERF_PERF
+    for ( int descriptor : descriptors_ ) close(descriptor);
+#endif
+}
+
+// Event opening
+// Generic hardware and cache events are used, so the kernel maps them to the
+// events of the running CPU
+int PerfCounters::open ( CounterEvent event ) {
+#ifdef TOPOPERF_PERF
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    uint64_t read_miss = ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) |
+        ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+    if ( event == CYCLES ) {
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    } else if ( event == INSTRUCTIONS ) {
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    } else if ( event == L1D_MISSES ) {
+        attr.config = PERF_COUNT_HW_CACHE_L1D | read_miss;
+    } else if ( event == LLC_MISSES ) {
+        attr.config = PERF_COUNT_HW_CACHE_LL | read_miss;
+    } else if ( event == DTLB_MISSES ) {
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | read_miss;
+    } else {
+        attr.config = PERF_COUNT_HW_CACHE_L1D |
+            ( PERF_COUNT_HW_CACHE_OP_PREFETCH << 8 ) |
+            ( PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16 );
+    }
+    attr.disabled = leader_ < 0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+        PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0ul);
+#else
+    (void) event;
+    return -1;
+#endif
+}
+
+bool PerfCounters::available ( CounterEvent event ) const {
+    for ( CounterEvent counted : events_ ) if ( counted == event ) return true;
+    return false;
+}
+
+void PerfCounters::start (  ) {
+#ifdef TOPOPERF_PERF
+    if ( leader_ < 0 ) return;
+    ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+void PerfCounters::pause (  ) {
+#ifdef TOPOPERF_PERF
+    if ( leader_ >= 0 ) ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+void PerfCounters::resume (  ) {
+#ifdef TOPOPERF_PERF
+    if ( leader_ >= 0 ) ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+// Group reading
+// The layout is { number of events, time enabled, time running, values }.
+// A group that never ran (e.g. more events than hardware counters) gives no
+// values
+CounterValues PerfCounters::stop (  ) {
+    CounterValues counters;
+#ifdef TOPOPERF_PERF
+    if ( leader_ < 0 ) return counters;
+    ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    uint64_t data[3 + COUNTER_EVENTS];
+    ssize_t bytes = read(leader_, data, sizeof(data));
+    if ( bytes < (ssize_t) ( 3 * sizeof(uint64_t) ) || data[2] == 0 )
+        return counters;
+    double scale = (double) data[1] / data[2];
+    for ( uint64_t i = 0; i < data[0] && i < events_.size(); ++i ) {
+        counters.values[events_[i]] = data[3 + i] * scale;
+        counters.available[events_[i]] = true;
+    }
+#endif
+    return counters;
+}
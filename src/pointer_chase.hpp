@@ -0,0 +1,203 @@
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include "buffer_arena.hpp"
+#include "distribution_generator.hpp"
+
+using namespace std;
+
+// Classes in this file
+class PointerChase;
+
+// Latency measured for one buffer size
+struct LatencyPoint {
+    uint_fast64_t size;     //Buffer size in bytes
+    double ns_per_load;     //Average time of one dependent load
+    uint_fast64_t page_size;    //Size of the pages backing the buffer
+};
+
+/****************************************************************************/
+// Latency engine based on a randomized dependent pointer chain.
+// The buffer is split in slots of stride_ bytes (a cache line by default) and
+// every slot stores the address of the next one. The order of the slots is a
+// random cycle, so each load depends on the previous one and hardware
+// prefetchers cannot guess the next address.
+// The buffer is allocated once with the largest size, and the chain is built
+// before the timed region of each size.
+// Example of use:
+//   //Measure 30 sizes between 4 KiB and 256 MiB
+//   DistributionGenerator *generator = DistributionGenerator::make_generator(
+//       4096, 256*1024*1024, EXPONENTIALLY_SPACED, 30);
+//   PointerChase chase;
+//   for ( LatencyPoint &point : chase.sweep(generator) )
+//       std::cout << point.size << " " << point.ns_per_load << std::endl;
+class PointerChase {
+    private:
+        void **buffer_ = nullptr;       //Memory where the chain lives
+        uint_fast64_t capacity_ = 0;    //Size of the buffer in bytes
+        bool owned_ = true;             //False if the buffer is an arena's
+        uint_fast64_t stride_;          //Distance between slots in bytes
+        uint_fast64_t loads_;           //Number of timed loads per size
+        uint_fast64_t page_size_;       //Size of the pages of the buffer
+        uint_fast64_t slots_ = 0;       //Number of slots in the current chain
+        void **position_ = nullptr;     //Where traverse continues the chain
+        vector<uint32_t> order_;        //Scratch space for the permutation
+                                        //(up to 2^32 slots, 256 GiB of lines)
+        Xoshiro256StarStar engine_;     //Source of the random permutation
+
+        //Grows the buffer to hold at least size bytes
+        void reserve ( uint_fast64_t size );
+        //Follows the chain for the given number of loads
+        void **chase ( void **start, uint_fast64_t loads ) const;
+
+    public:
+        //Constructor with the distance between slots and the number of
+        //dependent loads timed for each size
+        PointerChase ( uint_fast64_t stride = 64ul,
+                uint_fast64_t loads = 1ul << 20 );
+        ~PointerChase (  ) { if ( owned_ ) free(buffer_); }
+        PointerChase ( const PointerChase & ) = delete;
+        PointerChase &operator= ( const PointerChase & ) = delete;
+
+        //Builds chains in the memory of an arena instead of allocating.
+        //The arena must outlive the chase and hold the largest size
+        void attach ( BufferArena &arena );
+        //Builds a random chain covering size bytes (not timed)
+        void prepare ( uint_fast64_t size );
+        //Times the chain built by prepare and returns ns per load
+        double measure (  );
+        //Follows the chain for the number of timed loads, leaving the timing
+        //to the caller (e.g. a MeasurementHarness)
+        void traverse (  ) { if ( slots_ ) position_ = chase(position_, loads_); }
+        //Number of loads of measure and traverse
+        uint_fast64_t loads (  ) const { return loads_; }
+        //Number of slots visited before the chain returns to its start
+        uint_fast64_t chain_length (  ) const;
+        //Measures every size provided by the generator
+        vector<LatencyPoint> sweep ( DistributionGenerator *generator );
+        //Measures every size of a list (to repeat a sweep, e.g. per placement)
+        vector<LatencyPoint> sweep ( const vector<uint_fast64_t> &sizes );
+};
+
+/****************************************************************************/
+// Method implementations
+
+PointerChase::PointerChase ( uint_fast64_t stride, uint_fast64_t loads ) :
+    stride_ ( stride < sizeof(void*) ? sizeof(void*) : stride ),
+    // Loads are issued in blocks of 16 by chase
+    loads_ ( ((loads < 16ul ? 16ul : loads) + 15ul) & ~15ul ),
+    page_size_ ( sysconf(_SC_PAGESIZE) ),
+    engine_ ( random_seed() ) {  }
+
+void PointerChase::attach ( BufferArena &arena ) {
+    if ( owned_ ) free(buffer_);
+    buffer_ = arena.view<void*>(arena.size());
+    capacity_ = arena.size();
+    owned_ = false;
+    page_size_ = arena.page_size();
+    slots_ = 0;
+}
+
+// Buffer allocation
+// Only grows: a sweep reserves its largest size before measuring anything
+// Attached arenas cannot grow. Slots are indexed with 32 bits (order_), so
+// larger chains are rejected before anything is allocated
+void PointerChase::reserve ( uint_fast64_t size ) {
+    if ( size / stride_ > UINT32_MAX )
+        throw length_error("chain of " + to_string(size) +
+                " bytes exceeds 2^32 slots");
+    if ( size <= capacity_ ) return;
+    if ( ! owned_ )
+        throw length_error("chain of " + to_string(size) +
+                " bytes exceeds the attached arena");
+    void *memory = nullptr;
+    if ( posix_memalign(&memory, 4096, size) != 0 ) throw bad_alloc();
+    free(buffer_);
+    buffer_ = static_cast<void**>(memory);
+    capacity_ = size;
+}
+
+// Chain construction
+// Sattolo's algorithm produces a random permutation with a single cycle, so
+// every slot is visited before the chain repeats itself
+void PointerChase::prepare ( uint_fast64_t size ) {
+    reserve(size < stride_ ? stride_ : size);
+    slots_ = max(size / stride_, (uint_fast64_t) 1ul);
+    uint_fast64_t step = stride_ / sizeof(void*);
+
+    order_.resize(slots_);
+    for ( uint_fast64_t i = 0; i < slots_; ++i ) order_[i] = i;
+    for ( uint_fast64_t i = slots_ - 1; i > 0; --i ) {
+        uniform_int_distribution<uint_fast64_t> pick(0, i - 1);
+        swap(order_[i], order_[pick(engine_)]);
+    }
+    for ( uint_fast64_t i = 0; i < slots_; ++i )
+        buffer_[i * step] = &buffer_[order_[i] * step];
+    position_ = buffer_;
+}
+
+// Chain traversal
+// Unrolled so that loop control does not show up between dependent loads
+void **PointerChase::chase ( void **start, uint_fast64_t loads ) const {
+    void **p = start;
+    for ( uint_fast64_t i = 0; i < loads; i += 16ul ) {
+        p = (void**) *p; p = (void**) *p; p = (void**) *p; p = (void**) *p;
+        p = (void**) *p; p = (void**) *p; p = (void**) *p; p = (void**) *p;
+        p = (void**) *p; p = (void**) *p; p = (void**) *p; p = (void**) *p;
+        p = (void**) *p; p = (void**) *p; p = (void**) *p; p = (void**) *p;
+    }
+    return p;
+}
+
+// Latency measurement
+// A first pass over the chain (bounded by the number of timed loads) warms
+// caches and TLBs before the timed region
+double PointerChase::measure (  ) {
+    if ( slots_ == 0 ) return 0.0;
+    void **start = buffer_;
+    uint_fast64_t warmup = min((slots_ + 15ul) & ~15ul, loads_);
+    start = chase(start, warmup);
+
+    auto begin = chrono::steady_clock::now();
+    void ** volatile end = chase(start, loads_);
+    auto finish = chrono::steady_clock::now();
+    (void) end;
+
+    return chrono::duration<double, nano>(finish - begin).count() / loads_;
+}
+
+// Chain validation
+// Walks the chain from the first slot until it comes back to it
+uint_fast64_t PointerChase::chain_length (  ) const {
+    if ( slots_ == 0 ) return 0;
+    uint_fast64_t length = 1;
+    for ( void **p = (void**) *buffer_; p != buffer_; p = (void**) *p )
+        ++length;
+    return length;
+}
+
+// Sweep over the sizes of a generator
+vector<LatencyPoint> PointerChase::sweep ( DistributionGenerator *generator ) {
+    vector<uint_fast64_t> sizes;
+    while ( ! generator->is_done() ) sizes.push_back(generator->next());
+    return sweep(sizes);
+}
+
+// Sweep over a list of sizes
+// The buffer is allocated only once, with the largest size
+vector<LatencyPoint> PointerChase::sweep ( const vector<uint_fast64_t> &sizes ) {
+    if ( ! sizes.empty() ) reserve(*max_element(sizes.begin(), sizes.end()));
+
+    vector<LatencyPoint> points;
+    points.reserve(sizes.size());
+    for ( uint_fast64_t size : sizes ) {
+        prepare(size);
+        points.push_back( { size, measure(), page_size_ } );
+    }
+    return points;
+}
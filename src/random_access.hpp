@@ -0,0 +1,270 @@
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer_arena.hpp"
+#include "distribution_generator.hpp"
+#include "threading.hpp"
+
+using namespace std;
+
+// Classes in this file
+class RandomAccessEngine;
+
+// Kernels of the random access engine
+// With several threads, writes and updates of the same element are not
+// atomic, as in HPCC RandomAccess (GUPS): updates may be lost, which does not
+// change the memory traffic being measured
+enum RandomAccessKernel {
+    RANDOM_READ,    // sum += table[offset]
+    RANDOM_WRITE,   // table[offset] = offset
+    RANDOM_UPDATE   // table[offset] ^= offset (GUPS)
+};
+
+// Throughput measured for one table size and kernel
+struct RandomAccessPoint {
+    uint_fast64_t size;         //Size of the table in bytes
+    RandomAccessKernel kernel;  //Kernel that was measured
+    Generators pattern;         //Generator of the offsets
+    unsigned threads;           //Number of threads accessing the table
+    double mops;                //Accesses of all threads (10^6 per second)
+    double ns_per_access;       //Average time between accesses of a thread
+    uint_fast64_t page_size;    //Size of the pages backing the table
+};
+
+// Returns the name of a random access kernel
+string random_kernel_name ( RandomAccessKernel kernel );
+
+/****************************************************************************/
+// Engine that measures random access throughput over a shared table.
+// Offsets are drawn from a random generator (UniformlyRandom for uniform
+// access, ExponentiallyRandom for skewed locality towards the start of the
+// table) in bulk with fill, before the timed region. Each thread has its own
+// stream of offsets, and the kernels are unrolled so that eight independent
+// accesses are in flight, exposing memory-level parallelism instead of the
+// serialized latency of a pointer chase.
+// Threads share the whole table and are not synchronized, so concurrent
+// writes and updates race on shared lines (see RandomAccessKernel).
+// Example of use:
+//   DistributionGenerator *generator = DistributionGenerator::make_generator(
+//       1ul<<20, 1ul<<32, EXPONENTIALLY_SPACED, 12);
+//   RandomAccessEngine engine(8, vector<int>(), UNIFORMLY_RANDOM);
+//   for ( RandomAccessPoint &point : engine.sweep(generator, {RANDOM_UPDATE}) )
+//       std::cout << point.size << " " << point.mops << std::endl;
+class RandomAccessEngine {
+    private:
+        unsigned threads_;              //Number of threads
+        vector<int> cpus_;              //CPU of each thread
+        Generators pattern_;            //Generator of the offsets
+        uint_fast64_t accesses_;        //Offsets per thread
+        uint_fast64_t seed_;            //Seed of the offset generators
+        uint64_t *table_ = nullptr;     //Table being accessed
+        uint_fast64_t capacity_ = 0;    //Elements allocated in the table
+        uint_fast64_t elements_ = 0;    //Elements of the current size
+        bool owned_ = true;             //False if the table is an arena's
+        uint_fast64_t page_size_;       //Size of the pages of the table
+        vector<vector<uint_fast64_t>> offsets_; //Offsets of each thread
+
+        //Grows the table to hold size bytes
+        void reserve ( uint_fast64_t size );
+        //Runs a kernel over the offsets of a thread
+        uint64_t run ( RandomAccessKernel kernel, unsigned thread );
+        //Reads the part of the table of a thread sequentially
+        uint64_t warm ( unsigned thread ) const;
+
+    public:
+        //Constructor with the number of threads, their CPUs (round robin
+        //over the allowed CPUs if empty), the generator of the offsets, the
+        //number of accesses per thread and the seed of the offsets
+        RandomAccessEngine ( unsigned threads = thread::hardware_concurrency(),
+                vector<int> cpus = vector<int>(),
+                Generators pattern = UNIFORMLY_RANDOM,
+                uint_fast64_t accesses = 1ul << 20,
+                uint_fast64_t seed = random_seed() );
+        ~RandomAccessEngine (  ) { if ( owned_ ) free(table_); }
+        RandomAccessEngine ( const RandomAccessEngine & ) = delete;
+        RandomAccessEngine &operator= ( const RandomAccessEngine & ) = delete;
+
+        //Uses an arena as the table instead of allocating.
+        //The arena must outlive the engine
+        void attach ( BufferArena &arena );
+        //Sets the table to size bytes and generates the offsets (not timed)
+        void prepare ( uint_fast64_t size );
+        //Measures a kernel over the prepared table (in 10^6 accesses/s)
+        double measure ( RandomAccessKernel kernel );
+        //Number of threads
+        unsigned threads (  ) const { return threads_; }
+        //Offsets of a thread for the prepared size
+        const vector<uint_fast64_t> &offsets ( unsigned thread ) const {
+            return offsets_[thread];
+        }
+        //Measures every size of a list for each kernel
+        vector<RandomAccessPoint> sweep ( const vector<uint_fast64_t> &sizes,
+                const vector<RandomAccessKernel> &kernels =
+                    { RANDOM_READ, RANDOM_WRITE, RANDOM_UPDATE } );
+        //Measures every size provided by the generator for each kernel
+        vector<RandomAccessPoint> sweep ( DistributionGenerator *generator,
+                const vector<RandomAccessKernel> &kernels =
+                    { RANDOM_READ, RANDOM_WRITE, RANDOM_UPDATE } );
+};
+
+/****************************************************************************/
+// Method implementations
+
+string random_kernel_name ( RandomAccessKernel kernel ) {
+    if ( kernel == RANDOM_READ ) return "random_read";
+    else if ( kernel == RANDOM_WRITE ) return "random_write";
+    else return "random_update";
+}
+
+RandomAccessEngine::RandomAccessEngine ( unsigned threads, vector<int> cpus,
+        Generators pattern, uint_fast64_t accesses, uint_fast64_t seed ) :
+    threads_ ( threads == 0 ? 1u : threads ), pattern_ ( pattern ),
+    // Kernels process blocks of 8 offsets
+    accesses_ ( ( ( accesses < 8ul ? 8ul : accesses ) + 7ul ) & ~7ul ),
+    seed_ ( seed ), page_size_ ( sysconf(_SC_PAGESIZE) ),
+    offsets_ ( threads_ ) {
+    vector<int> allowed = cpus.empty() ? allowed_cpus() : cpus;
+    for ( unsigned t = 0; t < threads_; ++t )
+        cpus_.push_back(allowed[t % allowed.size()]);
+}
+
+void RandomAccessEngine::attach ( BufferArena &arena ) {
+    if ( owned_ ) free(table_);
+    table_ = arena.view<uint64_t>(arena.size());
+    capacity_ = arena.size() / sizeof(uint64_t);
+    owned_ = false;
+    page_size_ = arena.page_size();
+}
+
+// Table allocation
+// The table is initialized by the calling thread
+void RandomAccessEngine::reserve ( uint_fast64_t size ) {
+    uint_fast64_t elements = size / sizeof(uint64_t);
+    if ( elements <= capacity_ ) return;
+    if ( ! owned_ )
+        throw length_error("table of " + to_string(size) +
+                " bytes exceeds the attached arena");
+    void *memory = nullptr;
+    if ( posix_memalign(&memory, 4096, elements * sizeof(uint64_t)) != 0 )
+        throw bad_alloc();
+    free(table_);
+    table_ = static_cast<uint64_t*>(memory);
+    for ( uint_fast64_t i = 0; i < elements; ++i ) table_[i] = i;
+    capacity_ = elements;
+}
+
+// Offset generation
+// Offsets are drawn in [1, elements] (exponential generators cannot start at
+// zero) and moved to [0, elements). Every thread has its own seed
+void RandomAccessEngine::prepare ( uint_fast64_t size ) {
+    elements_ = max(size / sizeof(uint64_t), (uint_fast64_t) 2ul);
+    reserve(elements_ * sizeof(uint64_t));
+    for ( unsigned t = 0; t < threads_; ++t ) {
+        DistributionGenerator *generator = DistributionGenerator::make_generator(
+                1ul, elements_, pattern_, accesses_, seed_ + t);
+        offsets_[t].resize(accesses_);
+        uint_fast64_t generated = generator->fill(offsets_[t].data(), accesses_);
+        delete generator;
+        // Deterministic kinds may give fewer points: repeat them
+        for ( uint_fast64_t i = generated; i < accesses_; ++i )
+            offsets_[t][i] = offsets_[t][i % max(generated, (uint_fast64_t) 1ul)];
+        for ( uint_fast64_t &offset : offsets_[t] )
+            offset = min(offset - 1, elements_ - 1);
+    }
+}
+
+// Kernels
+// Eight accesses per iteration have no dependency between them
+uint64_t RandomAccessEngine::run ( RandomAccessKernel kernel, unsigned thread ) {
+    const uint_fast64_t *offsets = offsets_[thread].data();
+    uint64_t *table = table_;
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    if ( kernel == RANDOM_READ ) {
+        for ( uint_fast64_t i = 0; i < accesses_; i += 8 ) {
+            s0 += table[offsets[i]];     s1 += table[offsets[i + 1]];
+            s2 += table[offsets[i + 2]]; s3 += table[offsets[i + 3]];
+            s0 += table[offsets[i + 4]]; s1 += table[offsets[i + 5]];
+            s2 += table[offsets[i + 6]]; s3 += table[offsets[i + 7]];
+        }
+    } else if ( kernel == RANDOM_WRITE ) {
+        for ( uint_fast64_t i = 0; i < accesses_; i += 8 )
+            for ( uint_fast64_t j = i; j < i + 8; ++j )
+                table[offsets[j]] = offsets[j];
+    } else {
+        for ( uint_fast64_t i = 0; i < accesses_; i += 8 )
+            for ( uint_fast64_t j = i; j < i + 8; ++j )
+                table[offsets[j]] ^= offsets[j];
+    }
+    return s0 + s1 + s2 + s3;
+}
+
+// Warm-up
+// Threads read disjoint parts of the table. Replaying the offsets of the
+// timed pass instead would leave its lines in the caches, inflating the
+// throughput of tables that do not fit in them
+uint64_t RandomAccessEngine::warm ( unsigned thread ) const {
+    uint_fast64_t part = ( elements_ + threads_ - 1 ) / threads_;
+    uint_fast64_t begin = min(part * thread, elements_);
+    uint_fast64_t end = min(begin + part, elements_);
+    uint64_t sum = 0;
+    for ( uint_fast64_t i = begin; i < end; ++i ) sum += table_[i];
+    return sum;
+}
+
+// Throughput measurement
+// Same protocol as BandwidthEngine, except that the untimed pass reads the
+// table (see warm), then one timed pass between two barriers
+double RandomAccessEngine::measure ( RandomAccessKernel kernel ) {
+    SpinBarrier barrier(threads_);
+    chrono::steady_clock::time_point begin, finish;
+    vector<uint64_t> sinks(threads_);
+    vector<thread> workers;
+    for ( unsigned t = 0; t < threads_; ++t )
+        workers.emplace_back( [&, t] (  ) {
+            pin_current_thread(cpus_[t]);
+            sinks[t] = warm(t);
+            barrier.wait();
+            if ( t == 0 ) begin = chrono::steady_clock::now();
+            sinks[t] += run(kernel, t);
+            barrier.wait();
+            if ( t == 0 ) finish = chrono::steady_clock::now();
+        } );
+    for ( thread &worker : workers ) worker.join();
+
+    volatile uint64_t sink = 0;
+    for ( uint64_t value : sinks ) sink = sink + value;
+
+    double seconds = chrono::duration<double>(finish - begin).count();
+    return (double) accesses_ * threads_ / seconds / 1e6;
+}
+
+vector<RandomAccessPoint> RandomAccessEngine::sweep (
+        const vector<uint_fast64_t> &sizes,
+        const vector<RandomAccessKernel> &kernels ) {
+    if ( ! sizes.empty() ) reserve(*max_element(sizes.begin(), sizes.end()));
+    vector<RandomAccessPoint> points;
+    for ( uint_fast64_t size : sizes ) {
+        prepare(size);
+        for ( RandomAccessKernel kernel : kernels ) {
+            double mops = measure(kernel);
+            points.push_back( { size, kernel, pattern_, threads_, mops,
+                    1e3 * threads_ / mops, page_size_ } );
+        }
+    }
+    return points;
+}
+
+vector<RandomAccessPoint> RandomAccessEngine::sweep (
+        DistributionGenerator *generator,
+        const vector<RandomAccessKernel> &kernels ) {
+    vector<uint_fast64_t> sizes;
+    while ( ! generator->is_done() ) sizes.push_back(generator->next());
+    return sweep(sizes, kernels);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <random>
+
+using namespace std;
+
+// Classes in this file
+class Xoshiro256StarStar;
+class DeviceEngine;
+
+// Returns a seed drawn once from std::random_device
+uint_fast64_t random_seed (  );
+
+/****************************************************************************/
+// Fast seedable pseudo-random engine (xoshiro256** by Blackman and Vigna).
+// It satisfies the UniformRandomBitGenerator requirements, so it can be used
+// with the standard distributions. Two engines built with the same seed
+// produce the same sequence on every machine.
+// Example of use:
+//   Xoshiro256StarStar engine(42);
+//   std::uniform_int_distribution<uint_fast64_t> randomize(0, 100);
+//   uint_fast64_t point = randomize(engine);
+class Xoshiro256StarStar {
+    private:
+        uint64_t state_[4];     //Internal state (never all zeros)
+
+        static uint64_t rotl ( uint64_t x, int k ) {
+            return (x << k) | (x >> (64 - k));
+        }
+
+    public:
+        typedef uint64_t result_type;
+
+        //Constructor with a seed, expanded to the full state with splitmix64
+        explicit Xoshiro256StarStar ( uint_fast64_t seed = random_seed() );
+        static constexpr result_type min (  ) { return 0; }
+        static constexpr result_type max (  ) {
+            return numeric_limits<result_type>::max();
+        }
+        //Returns the next 64 random bits
+        result_type operator() (  );
+};
+
+/****************************************************************************/
+// Engine that draws every number from std::random_device. It is slow (a
+// system call per number on Linux) and cannot be replayed, and is kept to
+// compare against the previous behavior of the random generators.
+class DeviceEngine {
+    private:
+        random_device device_;
+    public:
+        typedef random_device::result_type result_type;
+
+        //The seed is ignored, as the device cannot be seeded
+        explicit DeviceEngine ( uint_fast64_t = 0 ) {  }
+        static constexpr result_type min (  ) { return random_device::min(); }
+        static constexpr result_type max (  ) { return random_device::max(); }
+        result_type operator() (  ) { return device_(); }
+};
+
+/****************************************************************************/
+// Method implementations
+
+// Seed generation
+// Combines two draws since random_device only provides 32 bits at a time
+uint_fast64_t random_seed (  ) {
+    random_device device;
+    return ( (uint_fast64_t) device() << 32 ) ^ device();
+}
+
+// Seeding with splitmix64, as recommended by the authors of xoshiro
+Xoshiro256StarStar::Xoshiro256StarStar ( uint_fast64_t seed ) {
+    uint64_t x = seed;
+    for ( int i = 0; i < 4; ++i ) {
+        uint64_t z = ( x += 0x9e3779b97f4a7c15ull );
+        z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+        z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+        state_[i] = z ^ ( z >> 31 );
+    }
+}
+
+// Generation operation of xoshiro256**
+Xoshiro256StarStar::result_type Xoshiro256StarStar::operator() (  ) {
+    const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+    const uint64_t t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = rotl(state_[3], 45);
+    return result;
+}
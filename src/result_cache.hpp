@@ -0,0 +1,275 @@
+#pragma once
+
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include "distribution_generator.hpp"
+#include "result_sink.hpp"
+
+using namespace std;
+
+// Classes in this file
+class ResultCache;
+
+// Identity of one measured point of a sweep. The host is added by the cache
+struct CacheKey {
+    string kernel;              //What is measured, with any setting that
+                                //changes its results (e.g. "bandwidth_read_t8")
+    Generators generator = AVERAGE_POINT;   //Sweep that produced the size
+    uint_fast64_t min = 0;
+    uint_fast64_t max = 0;
+    uint_fast64_t count_limit = 0;
+    int cpu = -1;               //Placement (-1 if not placed)
+    int node = -1;
+    uint_fast64_t size = 0;     //Measured size
+};
+
+// Returns an identifier of the machine: a hash of its host name, CPU model,
+// number of CPUs, memory size and kernel release, as 16 hex digits
+string host_fingerprint (  );
+
+/****************************************************************************/
+// Results of measured points kept in a file across runs.
+// Every point stored is appended to the file as one line and flushed at
+// once, so a sweep that is interrupted keeps what it measured, and running
+// it again measures only the points that are missing. Points are keyed by
+// host fingerprint, kernel, generator, limits, count limit, placement and
+// size, so a change of any of them (or of the machine) measures again, and
+// several hosts can share a file. Invalidated points are recorded with a
+// line without records, and later lines replace earlier ones when the file
+// is loaded. A truncated last line (e.g. after a crash) is ignored.
+// Lookups and stores are thread safe.
+// Example of use:
+//   ResultCache cache("topoperf.cache");
+//   CacheKey key;
+//   key.kernel = "latency";
+//   key.size = 4096;
+//   //Measures only if the point is not in the cache
+//   for ( ResultRecord &record : cache.fetch(key, [&] (  ) {
+//           return vector<ResultRecord>{ measure(4096) }; }) )
+//       sink.write(record);
+class ResultCache {
+    private:
+        // Key of a point in the file, with the host first
+        typedef tuple<string, string, int, uint_fast64_t, uint_fast64_t,
+                uint_fast64_t, int, int, uint_fast64_t> Key;
+
+        string host_;                   //Fingerprint of this machine
+        ofstream file_;                 //Closed if the cache is disabled
+        map<Key, vector<ResultRecord>> entries_;
+        uint_fast64_t hits_ = 0;        //Points found by fetch
+        uint_fast64_t misses_ = 0;      //Points measured by fetch
+        mutex mutex_;
+
+        //Key of a point of this host
+        Key key_of ( const CacheKey &key ) const;
+        //Appends the line of a point (no records for an invalidation)
+        void append ( const Key &key, const vector<ResultRecord> &records );
+        //Reads every valid line of a file
+        void load ( const string &path );
+
+    public:
+        //Constructor with the path of the cache file (created if missing)
+        //and the host of the points. An empty path disables the cache, so
+        //fetch always measures
+        ResultCache ( const string &path, const string &host = host_fingerprint() );
+        ResultCache ( const ResultCache & ) = delete;
+        ResultCache &operator= ( const ResultCache & ) = delete;
+
+        //True if points are kept in a file
+        bool enabled (  ) const { return file_.is_open(); }
+        //Host of the points looked up and stored
+        const string &host (  ) const { return host_; }
+        //Number of points of this host in the cache
+        uint_fast64_t size (  );
+        //Copies the records of a point to records. Returns false if the
+        //point is not in the cache
+        bool find ( const CacheKey &key, vector<ResultRecord> &records );
+        //Stores the records of a point, replacing any previous ones
+        void store ( const CacheKey &key, const vector<ResultRecord> &records );
+        //Returns the records of a point, calling measure and storing its
+        //records when the point is missing. Points measured without records
+        //(e.g. skipped at a deadline) are not stored
+        vector<ResultRecord> fetch ( const CacheKey &key,
+                const function<vector<ResultRecord>()> &measure );
+        //Invalidates the points of this host whose kernel starts with
+        //prefix (every point if it is empty). Returns how many were removed
+        uint_fast64_t invalidate ( const string &prefix = "" );
+        //Points found and measured by fetch since construction
+        uint_fast64_t hits (  ) const { return hits_; }
+        uint_fast64_t misses (  ) const { return misses_; }
+};
+
+/****************************************************************************/
+// Method implementations
+
+// Fingerprint
+// FNV-1a over the fields, separated by newlines. Sysfs and procfs fields
+// that cannot be read are left empty
+string host_fingerprint (  ) {
+    string text;
+    char name[256] = { 0 };
+    if ( gethostname(name, sizeof(name) - 1) == 0 ) text += name;
+    text += "\n";
+    ifstream cpuinfo("/proc/cpuinfo");
+    string line;
+    while ( getline(cpuinfo, line) )
+        if ( line.compare(0, 10, "model name") == 0 ) {
+            text += line;
+            break;
+        }
+    text += "\n" + to_string(thread::hardware_concurrency()) + "\n" +
+        to_string((uint_fast64_t) sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE)) + "\n";
+    utsname system;
+    if ( uname(&system) == 0 ) text += system.release;
+
+    uint64_t hash = 14695981039346656037ul;
+    for ( unsigned char c : text ) {
+        hash ^= c;
+        hash *= 1099511628211ul;
+    }
+    char digits[17];
+    snprintf(digits, sizeof(digits), "%016llx", (unsigned long long) hash);
+    return digits;
+}
+
+ResultCache::ResultCache ( const string &path, const string &host ) :
+    host_ ( host ) {
+    if ( path.empty() ) return;
+    load(path);
+    // A truncated last line is ended, so that it does not corrupt the next
+    ifstream last(path, ios::binary | ios::ate);
+    bool truncated = false;
+    if ( last && last.tellg() > 0 ) {
+        last.seekg(-1, ios::end);
+        truncated = last.get() != '\n';
+    }
+    file_.open(path, ios::binary | ios::app);
+    if ( ! file_ ) throw runtime_error("cannot open cache file " + path);
+    if ( truncated ) file_ << "\n";
+}
+
+ResultCache::Key ResultCache::key_of ( const CacheKey &key ) const {
+    return Key(host_, key.kernel, key.generator, key.min, key.max,
+            key.count_limit, key.cpu, key.node, key.size);
+}
+
+// Cache lines
+// The fields of the key are separated by commas, and the key and every
+// record (in the CSV format of ResultSink) by semicolons
+void ResultCache::append ( const Key &key, const vector<ResultRecord> &records ) {
+    string line = get<0>(key) + "," + get<1>(key) + "," +
+        generator_name((Generators) get<2>(key)) + "," + to_string(get<3>(key)) +
+        "," + to_string(get<4>(key)) + "," + to_string(get<5>(key)) + "," +
+        to_string(get<6>(key)) + "," + to_string(get<7>(key)) + "," +
+        to_string(get<8>(key));
+    for ( const ResultRecord &record : records ) {
+        line += ";";
+        ResultSink::encode(record, CSV, line);
+        line.pop_back();    // Newline of the record
+    }
+    line += "\n";
+    file_.write(line.data(), line.size());
+    file_.flush();
+}
+
+void ResultCache::load ( const string &path ) {
+    ifstream file(path, ios::binary);
+    string line;
+    while ( getline(file, line) ) {
+        stringstream parts(line);
+        string part;
+        vector<string> fields;
+        getline(parts, part, ';');
+        stringstream key_fields(part);
+        while ( getline(key_fields, part, ',') ) fields.push_back(part);
+        Generators generator;
+        if ( fields.size() != 9 || ! generator_from_name(fields[2], generator) )
+            continue;
+        vector<ResultRecord> records;
+        bool valid = true;
+        while ( valid && getline(parts, part, ';') ) {
+            ResultRecord record;
+            valid = parse_result(part, record);
+            records.push_back(record);
+        }
+        if ( ! valid ) continue;
+        try {
+            Key key(fields[0], fields[1], generator, stoull(fields[3]),
+                    stoull(fields[4]), stoull(fields[5]), stoi(fields[6]),
+                    stoi(fields[7]), stoull(fields[8]));
+            if ( records.empty() ) entries_.erase(key);
+            else entries_[key] = records;
+        } catch ( logic_error & ) {
+            continue;
+        }
+    }
+}
+
+uint_fast64_t ResultCache::size (  ) {
+    lock_guard<mutex> lock(mutex_);
+    uint_fast64_t points = 0;
+    for ( auto &entry : entries_ ) if ( get<0>(entry.first) == host_ ) ++points;
+    return points;
+}
+
+bool ResultCache::find ( const CacheKey &key, vector<ResultRecord> &records ) {
+    lock_guard<mutex> lock(mutex_);
+    auto found = entries_.find(key_of(key));
+    if ( found == entries_.end() ) return false;
+    records = found->second;
+    return true;
+}
+
+void ResultCache::store ( const CacheKey &key, const vector<ResultRecord> &records ) {
+    if ( key.kernel.find_first_of(",;\n") != string::npos )
+        throw invalid_argument("bad cache kernel " + key.kernel);
+    if ( ! enabled() || records.empty() ) return;
+    lock_guard<mutex> lock(mutex_);
+    Key point = key_of(key);
+    entries_[point] = records;
+    append(point, records);
+}
+
+// Cached measurement
+// The measurement runs without the lock, so measurements of other threads
+// are not serialized
+vector<ResultRecord> ResultCache::fetch ( const CacheKey &key,
+        const function<vector<ResultRecord>()> &measure ) {
+    vector<ResultRecord> records;
+    if ( find(key, records) ) {
+        lock_guard<mutex> lock(mutex_);
+        ++hits_;
+        return records;
+    }
+    records = measure();
+    store(key, records);
+    lock_guard<mutex> lock(mutex_);
+    ++misses_;
+    return records;
+}
+
+uint_fast64_t ResultCache::invalidate ( const string &prefix ) {
+    lock_guard<mutex> lock(mutex_);
+    uint_fast64_t removed = 0;
+    for ( auto entry = entries_.begin(); entry != entries_.end(); ) {
+        if ( get<0>(entry->first) == host_ &&
+                get<1>(entry->first).compare(0, prefix.size(), prefix) == 0 ) {
+            if ( enabled() ) append(entry->first, vector<ResultRecord>());
+            entry = entries_.erase(entry);
+            ++removed;
+        } else ++entry;
+    }
+    return removed;
+}
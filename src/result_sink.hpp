@@ -0,0 +1,430 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "distribution_generator.hpp"
+#include "timing.hpp"
+
+using namespace std;
+
+// Classes in this file
+class ResultSink;
+
+// Formats of result files
+enum ResultFormat {
+    CSV,            // Header line and one line per record
+    JSON_LINES,     // One JSON object per line
+    BINARY          // Magic number and fixed-layout records
+};
+
+// One measured value with its context
+struct ResultRecord {
+    Generators generator = AVERAGE_POINT;   //Kind of generator of the size
+    uint_fast64_t size = 0;         //Size of the measurement in bytes
+    int cpu = -1;                   //Executing CPU (-1 if not placed)
+    int node = -1;                  //Memory node (-1 if not placed)
+    unsigned threads = 1;           //Threads doing the measurement
+    string metric;                  //What was measured (e.g. "latency_ns")
+    uint_fast64_t page_size = 0;    //Page size of the buffer (0 if unknown)
+    double value = 0.0;             //Main value (mean of the repetitions)
+    double min = 0.0;
+    double median = 0.0;
+    double p99 = 0.0;
+    double ci95 = 0.0;
+    uint_fast64_t samples = 1;      //Number of repetitions
+
+    //Copies the statistics of a timed measurement
+    void set_stats ( const TimingStats &stats );
+};
+
+// Comparison of one record present in two result files
+struct ResultDiff {
+    ResultRecord before;
+    ResultRecord after;
+    double change;      //Relative change of value: (after - before) / before
+};
+
+// Returns one record per available counter of the statistics of record,
+// with the counter name as metric (e.g. "dtlb_misses") and the same context
+vector<ResultRecord> counter_records ( const ResultRecord &record,
+        const TimingStats &stats );
+// Same for counters measured without statistics, with a prefix added to the
+// counter names (e.g. "tlb_" for "tlb_dtlb_misses")
+vector<ResultRecord> counter_records ( const ResultRecord &record,
+        const CounterValues &counters, const string &prefix = "" );
+// Returns the name of a result format ("csv", "jsonl" or "bin")
+string format_name ( ResultFormat format );
+// Parses a CSV or JSON line written by ResultSink. Returns false if it is
+// malformed
+bool parse_result ( const string &line, ResultRecord &record );
+// Loads a result file in any format (detected from its content)
+vector<ResultRecord> load_results ( const string &path );
+// Matches the records of two result sets by generator, size, placement,
+// threads, metric and page size, sorted by metric and size
+vector<ResultDiff> diff_results ( const vector<ResultRecord> &before,
+        const vector<ResultRecord> &after );
+
+/****************************************************************************/
+// Streams result records to a file as they are produced.
+// write only appends the record to a buffer; a background thread encodes and
+// writes batches of records, so file I/O never happens in the thread doing
+// the measurements.
+// Example of use:
+//   ResultSink sink("results.csv", CSV);
+//   ResultRecord record;
+//   record.size = 4096;
+//   record.metric = "latency_ns";
+//   record.value = 1.2;
+//   sink.write(record);
+class ResultSink {
+    private:
+        ofstream file_;
+        ostream *out_;                  //file_, or cout for the path "-"
+        ResultFormat format_;
+        size_t batch_;                  //Records that wake up the writer
+        vector<ResultRecord> pending_;  //Records not yet written
+        uint_fast64_t submitted_ = 0;   //Records received by write
+        uint_fast64_t written_ = 0;     //Records written to the file
+        bool flushing_ = false;
+        bool closing_ = false;
+        mutex mutex_;
+        condition_variable wake_writer_;
+        condition_variable written_cv_;
+        thread writer_;
+
+        //Loop of the background writer
+        void write_loop (  );
+
+    public:
+        //Constructor with the path of the file (truncated, or "-" for the
+        //standard output), its format and the number of records buffered
+        //before a write
+        ResultSink ( const string &path, ResultFormat format = CSV,
+                size_t batch = 1024 );
+        ~ResultSink (  ) { close(); }
+        ResultSink ( const ResultSink & ) = delete;
+        ResultSink &operator= ( const ResultSink & ) = delete;
+
+        //Queues a record to be written
+        void write ( const ResultRecord &record );
+        //Blocks until every queued record is in the file
+        void flush (  );
+        //Writes every queued record and stops the writer
+        void close (  );
+        //Encodes a record in a format (without the file header)
+        static void encode ( const ResultRecord &record, ResultFormat format,
+                string &out );
+};
+
+/****************************************************************************/
+// Method implementations
+
+void ResultRecord::set_stats ( const TimingStats &stats ) {
+    value = stats.mean;
+    min = stats.min;
+    median = stats.median;
+    p99 = stats.p99;
+    ci95 = stats.ci95;
+    samples = stats.samples;
+}
+
+// Counter records
+// Counters are not repeated per sample, so only value is set
+vector<ResultRecord> counter_records ( const ResultRecord &record,
+        const TimingStats &stats ) {
+    return counter_records(record, stats.counters);
+}
+
+vector<ResultRecord> counter_records ( const ResultRecord &record,
+        const CounterValues &counters, const string &prefix ) {
+    vector<ResultRecord> records;
+    for ( unsigned event = 0; event < COUNTER_EVENTS; ++event ) {
+        if ( ! counters.available[event] ) continue;
+        ResultRecord counter = record;
+        counter.metric = prefix + counter_name((CounterEvent) event);
+        counter.value = counter.min = counter.median = counter.p99 =
+            counters.values[event];
+        counter.ci95 = 0.0;
+        counter.samples = 1;
+        records.push_back(counter);
+    }
+    return records;
+}
+
+string format_name ( ResultFormat format ) {
+    if ( format == CSV ) return "csv";
+    else if ( format == JSON_LINES ) return "jsonl";
+    else return "bin";
+}
+
+// Header of CSV files and magic number of binary files
+const char *RESULT_CSV_HEADER =
+    "generator,size,cpu,node,threads,metric,page_size,value,min,median,p99,ci95,samples";
+const char RESULT_MAGIC[8] = { 'T', 'O', 'P', 'O', 'P', 'R', 'F', '1' };
+
+// Appends a value to a binary record
+template <typename T>
+void append_binary ( string &out, T value ) {
+    out.append((const char*) &value, sizeof(value));
+}
+
+// Record encoding
+// Numbers are printed with 17 significant digits so that loading them back
+// gives the same doubles
+void ResultSink::encode ( const ResultRecord &record, ResultFormat format,
+        string &out ) {
+    char numbers[256];
+    if ( format == BINARY ) {
+        append_binary<uint8_t>(out, record.generator);
+        append_binary<uint64_t>(out, record.size);
+        append_binary<int32_t>(out, record.cpu);
+        append_binary<int32_t>(out, record.node);
+        append_binary<uint32_t>(out, record.threads);
+        append_binary<uint16_t>(out, record.metric.size());
+        out.append(record.metric);
+        append_binary<uint64_t>(out, record.page_size);
+        append_binary<double>(out, record.value);
+        append_binary<double>(out, record.min);
+        append_binary<double>(out, record.median);
+        append_binary<double>(out, record.p99);
+        append_binary<double>(out, record.ci95);
+        append_binary<uint64_t>(out, record.samples);
+    } else if ( format == JSON_LINES ) {
+        out += "{\"generator\":\"" + generator_name(record.generator) +
+            "\",\"size\":" + to_string(record.size) +
+            ",\"cpu\":" + to_string(record.cpu) +
+            ",\"node\":" + to_string(record.node) +
+            ",\"threads\":" + to_string(record.threads) +
+            ",\"metric\":\"" + record.metric +
+            "\",\"page_size\":" + to_string(record.page_size);
+        snprintf(numbers, sizeof(numbers), ",\"value\":%.17g,\"min\":%.17g,"
+                "\"median\":%.17g,\"p99\":%.17g,\"ci95\":%.17g,",
+                record.value, record.min, record.median, record.p99, record.ci95);
+        out += numbers;
+        out += "\"samples\":" + to_string(record.samples) + "}\n";
+    } else {
+        out += generator_name(record.generator) + "," + to_string(record.size) +
+            "," + to_string(record.cpu) + "," + to_string(record.node) + "," +
+            to_string(record.threads) + "," + record.metric + "," + to_string(record.page_size);
+        snprintf(numbers, sizeof(numbers), ",%.17g,%.17g,%.17g,%.17g,%.17g,",
+                record.value, record.min, record.median, record.p99, record.ci95);
+        out += numbers;
+        out += to_string(record.samples) + "\n";
+    }
+}
+
+ResultSink::ResultSink ( const string &path, ResultFormat format, size_t batch ) :
+    out_ ( &cout ), format_ ( format ),
+    batch_ ( batch == 0 ? 1 : batch ) {
+    if ( path != "-" ) {
+        file_.open(path, ios::binary | ios::trunc);
+        if ( ! file_ ) throw runtime_error("cannot open result file " + path);
+        out_ = &file_;
+    }
+    if ( format_ == CSV ) *out_ << RESULT_CSV_HEADER << "\n";
+    if ( format_ == BINARY ) out_->write(RESULT_MAGIC, sizeof(RESULT_MAGIC));
+    pending_.reserve(batch_);
+    writer_ = thread(&ResultSink::write_loop, this);
+}
+
+void ResultSink::write ( const ResultRecord &record ) {
+    lock_guard<mutex> lock(mutex_);
+    pending_.push_back(record);
+    ++submitted_;
+    if ( pending_.size() >= batch_ ) wake_writer_.notify_one();
+}
+
+// Background writing
+// Batches are taken out of the buffer under the lock and encoded outside it
+void ResultSink::write_loop (  ) {
+    vector<ResultRecord> batch;
+    string out;
+    unique_lock<mutex> lock(mutex_);
+    while ( true ) {
+        wake_writer_.wait(lock, [this] (  ) {
+            return pending_.size() >= batch_ || flushing_ || closing_;
+        });
+        bool last = closing_;
+        batch.swap(pending_);
+        lock.unlock();
+
+        out.clear();
+        for ( const ResultRecord &record : batch ) encode(record, format_, out);
+        out_->write(out.data(), out.size());
+        out_->flush();
+
+        lock.lock();
+        written_ += batch.size();
+        batch.clear();
+        if ( written_ == submitted_ ) flushing_ = false;
+        written_cv_.notify_all();
+        if ( last && pending_.empty() ) return;
+    }
+}
+
+void ResultSink::flush (  ) {
+    unique_lock<mutex> lock(mutex_);
+    if ( ! writer_.joinable() ) return;
+    flushing_ = true;
+    wake_writer_.notify_one();
+    written_cv_.wait(lock, [this] (  ) { return written_ == submitted_; });
+}
+
+void ResultSink::close (  ) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if ( ! writer_.joinable() ) return;
+        closing_ = true;
+        wake_writer_.notify_one();
+    }
+    writer_.join();
+    if ( file_.is_open() ) file_.close();
+}
+
+// Binary reading helper
+// Returns false at the end of the file
+template <typename T>
+bool read_binary ( ifstream &file, T &value ) {
+    return (bool) file.read((char*) &value, sizeof(value));
+}
+
+// Extracts the text of a field of a JSON line written by ResultSink
+string json_field ( const string &line, const string &key ) {
+    string pattern = "\"" + key + "\":";
+    size_t start = line.find(pattern);
+    if ( start == string::npos ) return "";
+    start += pattern.size();
+    if ( line[start] == '"' ) {
+        size_t end = line.find('"', start + 1);
+        return line.substr(start + 1, end - start - 1);
+    }
+    size_t end = line.find_first_of(",}", start);
+    return line.substr(start, end - start);
+}
+
+// Result loading
+// The format is detected from the first bytes of the file
+vector<ResultRecord> load_results ( const string &path ) {
+    ifstream file(path, ios::binary);
+    if ( ! file ) throw runtime_error("cannot open result file " + path);
+    vector<ResultRecord> records;
+    char magic[sizeof(RESULT_MAGIC)] = { 0 };
+    file.read(magic, sizeof(magic));
+    if ( file && memcmp(magic, RESULT_MAGIC, sizeof(magic)) == 0 ) {
+        ResultRecord record;
+        uint8_t generator;
+        while ( read_binary(file, generator) ) {
+            uint64_t size, page_size, samples;
+            int32_t cpu, node;
+            uint32_t threads;
+            uint16_t length;
+            read_binary(file, size);
+            read_binary(file, cpu);
+            read_binary(file, node);
+            read_binary(file, threads);
+            read_binary(file, length);
+            record.metric.assign(length, ' ');
+            file.read(&record.metric[0], length);
+            read_binary(file, page_size);
+            read_binary(file, record.value);
+            read_binary(file, record.min);
+            read_binary(file, record.median);
+            read_binary(file, record.p99);
+            read_binary(file, record.ci95);
+            if ( ! read_binary(file, samples) )
+                throw runtime_error("truncated result file " + path);
+            record.generator = (Generators) generator;
+            record.size = size;
+            record.cpu = cpu;
+            record.node = node;
+            record.threads = threads;
+            record.page_size = page_size;
+            record.samples = samples;
+            records.push_back(record);
+        }
+        return records;
+    }
+
+    file.clear();
+    file.seekg(0);
+    string line;
+    while ( getline(file, line) ) {
+        if ( line.empty() || line == RESULT_CSV_HEADER ) continue;
+        ResultRecord record;
+        if ( ! parse_result(line, record) )
+            throw runtime_error("malformed result line: " + line);
+        records.push_back(record);
+    }
+    return records;
+}
+
+// Line parsing
+// Numbers that do not parse make the whole line malformed
+bool parse_result ( const string &line, ResultRecord &record ) {
+    vector<string> fields;
+    if ( ! line.empty() && line[0] == '{' ) {
+        const char *keys[] = { "generator", "size", "cpu", "node", "threads",
+            "metric", "page_size", "value", "min", "median", "p99", "ci95",
+            "samples" };
+        for ( const char *key : keys ) fields.push_back(json_field(line, key));
+    } else {
+        stringstream stream(line);
+        string field;
+        while ( getline(stream, field, ',') ) fields.push_back(field);
+    }
+    if ( fields.size() != 13 || ! generator_from_name(fields[0], record.generator) )
+        return false;
+    try {
+        record.size = stoull(fields[1]);
+        record.cpu = stoi(fields[2]);
+        record.node = stoi(fields[3]);
+        record.threads = stoul(fields[4]);
+        record.metric = fields[5];
+        record.page_size = stoull(fields[6]);
+        record.value = stod(fields[7]);
+        record.min = stod(fields[8]);
+        record.median = stod(fields[9]);
+        record.p99 = stod(fields[10]);
+        record.ci95 = stod(fields[11]);
+        record.samples = stoull(fields[12]);
+    } catch ( logic_error & ) {
+        return false;
+    }
+    return true;
+}
+
+// Result comparison
+// Records are matched with an ordered map, which also gives the output order
+vector<ResultDiff> diff_results ( const vector<ResultRecord> &before,
+        const vector<ResultRecord> &after ) {
+    typedef tuple<string, uint_fast64_t, int, int, int, unsigned, uint_fast64_t> Key;
+    map<Key, ResultRecord> earlier;
+    for ( const ResultRecord &record : before )
+        earlier[Key(record.metric, record.size, record.generator, record.cpu,
+                record.node, record.threads, record.page_size)] = record;
+    map<Key, ResultDiff> matched;
+    for ( const ResultRecord &record : after ) {
+        Key key(record.metric, record.size, record.generator, record.cpu,
+                record.node, record.threads, record.page_size);
+        auto found = earlier.find(key);
+        if ( found == earlier.end() ) continue;
+        double change = found->second.value != 0.0 ?
+            ( record.value - found->second.value ) / found->second.value : 0.0;
+        matched[key] = { found->second, record, change };
+    }
+    vector<ResultDiff> diffs;
+    for ( auto &entry : matched ) diffs.push_back(entry.second);
+    return diffs;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+// Compile-time generators require C++14 (constexpr functions with loops)
+#if __cplusplus < 201402L
+#error "static_generators.hpp requires C++14 or later"
+#endif
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+#include "distribution_generator.hpp"
+
+using namespace std;
+
+// Classes in this file
+template <Generators Kind, uint_fast64_t Min, uint_fast64_t Max,
+         uint_fast64_t Count> class SpacedSequence;
+
+/****************************************************************************/
+// index-th point of an interval split in parts exponential parts, computed
+// with Real as the runtime generators do
+template <typename Real>
+constexpr uint_fast64_t exponential_part ( uint_fast64_t min, uint_fast64_t max,
+        uint_fast64_t parts, uint_fast64_t index ) {
+    return exponential_point(exponential_exponent(series_log<Real>(min),
+                series_log<Real>(max) - series_log<Real>(min), parts, index),
+            min, max);
+}
+
+// index-th point of a deterministic generator, as produced by the runtime
+// generators of distribution_generator.hpp, with the same series_log and
+// series_exp, and the same extended precision above EXACT_DOUBLE_LIMIT.
+// Limits must already be normalized (min < max, and min > 0 for exponential
+// kinds)
+constexpr uint_fast64_t spaced_point ( Generators kind, uint_fast64_t min,
+        uint_fast64_t max, uint_fast64_t count, uint_fast64_t index ) {
+    if ( kind == AVERAGE_POINT ) return average_point(min, max);
+    if ( kind == UNIFORMLY_SPACED )
+        return uniform_point(min, max, count + 1, index + 1);
+    uint_fast64_t parts = kind == MID_POINT ? 2 : count + 1;
+    uint_fast64_t part = kind == MID_POINT ? 1 : index + 1;
+    return max > EXACT_DOUBLE_LIMIT ?
+        exponential_part<long double>(min, max, parts, part) :
+        exponential_part<double>(min, max, parts, part);
+}
+
+/****************************************************************************/
+// Sequence of sizes computed at compile time.
+// It gives the same points as make_generator(Min, Max, Kind, Count) for the
+// deterministic kinds, with the same normalization of the limits, stored in
+// a constexpr std::array. Iterating over it has no virtual dispatch, so
+// measurement loops over the sizes can be fully inlined.
+// Example of use:
+//   //64 exponentially spaced sizes between 4 KiB and 1 GiB
+//   typedef SpacedSequence<EXPONENTIALLY_SPACED, 4096, 1ul<<30, 64> Sizes;
+//   static_assert(Sizes::points[0] > 4096, "sizes are computed at compile time");
+//   for ( uint_fast64_t size : Sizes() ) measure(size);
+template <Generators Kind, uint_fast64_t Min, uint_fast64_t Max,
+         uint_fast64_t Count = 1ul>
+class SpacedSequence {
+    static_assert(Kind != UNIFORMLY_RANDOM && Kind != EXPONENTIALLY_RANDOM,
+            "random generators cannot be computed at compile time");
+
+    private:
+        // Limits normalized like in make_generator
+        static constexpr uint_fast64_t low_ = Min < Max ? Min : Max;
+        static constexpr uint_fast64_t high_ = Min < Max ? Max : Min;
+        static constexpr uint_fast64_t min_ = low_ != high_ ? low_ :
+            ( high_ < UINT_FAST64_MAX ? low_ : low_ - 1 );
+        static constexpr uint_fast64_t max_ = low_ != high_ ? high_ :
+            ( high_ < UINT_FAST64_MAX ? high_ + 1 : high_ );
+        static constexpr uint_fast64_t count_ = Count == 0 ? 1ul : Count;
+        // Exponential kinds do not use zero as lower limit
+        static constexpr bool exponential_ =
+            Kind == EXPONENTIALLY_SPACED || Kind == MID_POINT;
+        static constexpr uint_fast64_t first_ =
+            exponential_ && min_ == 0 ? 1ul : min_;
+
+        template <size_t... Index>
+        static constexpr array<uint_fast64_t, sizeof...(Index)> make (
+                index_sequence<Index...> ) {
+            return {{ spaced_point(Kind, first_, max_, count_, Index)... }};
+        }
+
+    public:
+        //Number of points in the sequence
+        static constexpr size_t size =
+            Kind == AVERAGE_POINT || Kind == MID_POINT ? 1 : count_;
+        //Points of the sequence
+        static constexpr array<uint_fast64_t, size> points =
+            make(make_index_sequence<size>());
+
+        typedef typename array<uint_fast64_t, size>::const_iterator const_iterator;
+        const_iterator begin (  ) const { return points.begin(); }
+        const_iterator end (  ) const { return points.end(); }
+        //Copies the points to a vector (e.g. for sweep methods)
+        static vector<uint_fast64_t> to_vector (  ) {
+            return vector<uint_fast64_t>(points.begin(), points.end());
+        }
+};
+
+// Definition of the static array (required before C++17 when it is odr-used)
+template <Generators Kind, uint_fast64_t Min, uint_fast64_t Max,
+         uint_fast64_t Count>
+constexpr array<uint_fast64_t, SpacedSequence<Kind, Min, Max, Count>::size>
+    SpacedSequence<Kind, Min, Max, Count>::points;
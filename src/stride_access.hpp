@@ -0,0 +1,222 @@
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "distribution_generator.hpp"
+#include "perf_counters.hpp"
+#include "random_engine.hpp"
+
+using namespace std;
+
+// Classes in this file
+class StrideAccess;
+
+// Order in which the slots of a stride are visited
+enum AccessOrder {
+    FORWARD,        // Increasing addresses, a constant stride prefetchers follow
+    SHUFFLED        // Random order of the same slots, which defeats prefetchers
+};
+
+// Latency and bandwidth measured for one stride and order
+struct StridePoint {
+    uint_fast64_t stride;   //Distance between accessed words in bytes
+    AccessOrder order;      //Order of the accesses
+    double ns_per_load;     //Average time of one dependent load
+    double ns_per_access;   //Average time of one independent load
+    double gb_per_s;        //Cache lines (or parts of lines, for strides
+                            //under 64 B) brought per second (10^9 B/s)
+    CounterValues counters; //Hardware counters per dependent load (if
+                            //counters are attached)
+};
+
+// Returns the name of an access order
+string access_order_name ( AccessOrder order );
+
+/****************************************************************************/
+// Strided accesses over a fixed buffer.
+// The buffer is split in slots of stride bytes and one word of every slot is
+// accessed, either in increasing order or in a random order. Each stride is
+// measured twice: as a chain of dependent loads (every word holds the
+// address of the next one), which gives latency, and as independent loads
+// of the same words, which gives throughput. Comparing FORWARD and SHUFFLED
+// for the same stride shows what the prefetchers gain, and strides crossing
+// cache lines and pages show their cost.
+// Strides are rounded down to whole words (8 bytes), and to half of the
+// buffer so that there are at least two slots. Attached PerfCounters count
+// the timed chain of dependent loads.
+// Example of use:
+//   //Strides from 8 B to 16 KiB over 64 MiB
+//   DistributionGenerator *generator = DistributionGenerator::make_generator(
+//       8, 16*1024, EXPONENTIALLY_SPACED, 12);
+//   StrideAccess access(64ul << 20);
+//   for ( StridePoint &point : access.sweep(generator) )
+//       std::cout << point.stride << " " << access_order_name(point.order)
+//           << " " << point.ns_per_load << " " << point.gb_per_s << std::endl;
+class StrideAccess {
+    private:
+        uint64_t *buffer_ = nullptr;    //Accessed memory
+        uint_fast64_t size_;            //Size of the buffer in bytes
+        uint_fast64_t loads_;           //Timed loads per measurement
+        vector<uint32_t> order_;        //Slots in the order of the accesses
+        Xoshiro256StarStar engine_;     //Source of the random orders
+        PerfCounters *counters_ = nullptr;  //Counters around the timed chain
+
+        //Builds the order of the slots and the chain through them
+        void prepare ( uint_fast64_t step, uint_fast64_t slots, AccessOrder order );
+        //Follows the chain for a number of loads
+        uint64_t *chase ( uint64_t *start, uint_fast64_t loads ) const;
+        //Loads the words of every slot (in order) until loads are done
+        uint64_t scan ( uint_fast64_t step, uint_fast64_t slots, AccessOrder order,
+                uint_fast64_t loads ) const;
+
+    public:
+        //Constructor with the size of the buffer and the number of timed
+        //loads of each measurement
+        StrideAccess ( uint_fast64_t size = 64ul << 20,
+                uint_fast64_t loads = 1ul << 20,
+                uint_fast64_t seed = random_seed() );
+        ~StrideAccess (  ) { free(buffer_); }
+        StrideAccess ( const StrideAccess & ) = delete;
+        StrideAccess &operator= ( const StrideAccess & ) = delete;
+
+        //Counts hardware events over the timed chain of every measurement.
+        //The counters must outlive the object and belong to the calling
+        //thread
+        void attach ( PerfCounters &counters ) { counters_ = &counters; }
+        //Measures one stride in one order
+        StridePoint measure ( uint_fast64_t stride, AccessOrder order );
+        //Measures every stride provided by the generator in each order
+        vector<StridePoint> sweep ( DistributionGenerator *generator,
+                const vector<AccessOrder> &orders = { FORWARD, SHUFFLED } );
+};
+
+/****************************************************************************/
+// Method implementations
+
+string access_order_name ( AccessOrder order ) {
+    if ( order == FORWARD ) return "forward";
+    else return "shuffled";
+}
+
+// Buffer allocation
+// The buffer is written once so that no page fault happens while measuring
+StrideAccess::StrideAccess ( uint_fast64_t size, uint_fast64_t loads,
+        uint_fast64_t seed ) :
+    size_ ( max(size, (uint_fast64_t) 4096ul) & ~(uint_fast64_t) 4095ul ),
+    // Loads are issued in blocks of 8
+    loads_ ( ( max(loads, (uint_fast64_t) 8ul) + 7ul ) & ~7ul ),
+    engine_ ( seed ) {
+    void *memory = nullptr;
+    if ( posix_memalign(&memory, 4096, size_) != 0 ) throw bad_alloc();
+    buffer_ = static_cast<uint64_t*>(memory);
+    for ( uint_fast64_t i = 0; i < size_ / sizeof(uint64_t); ++i ) buffer_[i] = 0;
+}
+
+// Chain construction
+// A shuffled order is a random permutation of the slots other than the
+// first (Sattolo's algorithm would also work, but keeping slot 0 first lets
+// both orders start the chain at the beginning of the buffer)
+void StrideAccess::prepare ( uint_fast64_t step, uint_fast64_t slots,
+        AccessOrder order ) {
+    order_.resize(slots);
+    for ( uint_fast64_t i = 0; i < slots; ++i ) order_[i] = i;
+    if ( order == SHUFFLED )
+        for ( uint_fast64_t i = slots - 1; i > 1; --i ) {
+            uniform_int_distribution<uint_fast64_t> pick(1, i);
+            swap(order_[i], order_[pick(engine_)]);
+        }
+    for ( uint_fast64_t i = 0; i < slots; ++i )
+        buffer_[order_[i] * step] =
+            (uint64_t) &buffer_[order_[( i + 1 ) % slots] * step];
+}
+
+// Chain traversal
+// Unrolled like PointerChase::chase
+uint64_t *StrideAccess::chase ( uint64_t *start, uint_fast64_t loads ) const {
+    uint64_t *p = start;
+    for ( uint_fast64_t i = 0; i < loads; i += 8ul ) {
+        p = (uint64_t*) *p; p = (uint64_t*) *p; p = (uint64_t*) *p;
+        p = (uint64_t*) *p; p = (uint64_t*) *p; p = (uint64_t*) *p;
+        p = (uint64_t*) *p; p = (uint64_t*) *p;
+    }
+    return p;
+}
+
+// Independent loads
+// The forward order is a plain strided loop; the shuffled one reads the
+// slot numbers from order_, a sequential stream that prefetchers handle
+uint64_t StrideAccess::scan ( uint_fast64_t step, uint_fast64_t slots,
+        AccessOrder order, uint_fast64_t loads ) const {
+    const uint64_t *buffer = buffer_;
+    const uint32_t *positions = order_.data();
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    uint_fast64_t done = 0;
+    while ( done < loads ) {
+        uint_fast64_t n = min(slots, loads - done) & ~(uint_fast64_t) 3ul;
+        if ( n == 0 ) n = min(slots, loads - done);
+        uint_fast64_t i = 0;
+        if ( order == FORWARD ) {
+            for ( ; i + 4 <= n; i += 4 ) {
+                s0 += buffer[i * step];           s1 += buffer[( i + 1 ) * step];
+                s2 += buffer[( i + 2 ) * step];   s3 += buffer[( i + 3 ) * step];
+            }
+            for ( ; i < n; ++i ) s0 += buffer[i * step];
+        } else {
+            for ( ; i + 4 <= n; i += 4 ) {
+                s0 += buffer[positions[i] * step];
+                s1 += buffer[positions[i + 1] * step];
+                s2 += buffer[positions[i + 2] * step];
+                s3 += buffer[positions[i + 3] * step];
+            }
+            for ( ; i < n; ++i ) s0 += buffer[positions[i] * step];
+        }
+        done += n;
+    }
+    return s0 + s1 + s2 + s3;
+}
+
+// Stride measurement
+// Both measurements are preceded by an untimed pass over every slot (at
+// most loads of them), which warms caches and TLBs
+StridePoint StrideAccess::measure ( uint_fast64_t stride, AccessOrder order ) {
+    stride = min(stride, size_ / 2);
+    uint_fast64_t step = max(stride / sizeof(uint64_t), (uint_fast64_t) 1ul);
+    stride = step * sizeof(uint64_t);
+    uint_fast64_t slots = size_ / stride;
+    slots = min(slots, (uint_fast64_t) UINT32_MAX);
+    prepare(step, slots, order);
+    uint_fast64_t warmup = min(( slots + 7ul ) & ~7ul, loads_);
+
+    uint64_t *start = chase(buffer_, warmup);
+    if ( counters_ ) counters_->start();
+    auto begin = chrono::steady_clock::now();
+    uint64_t * volatile end = chase(start, loads_);
+    auto finish = chrono::steady_clock::now();
+    (void) end;
+    CounterValues counters;
+    if ( counters_ ) counters = counters_->stop().per(loads_);
+    double latency = chrono::duration<double, nano>(finish - begin).count() / loads_;
+
+    volatile uint64_t sink = scan(step, slots, order, warmup);
+    begin = chrono::steady_clock::now();
+    sink = sink + scan(step, slots, order, loads_);
+    finish = chrono::steady_clock::now();
+    double ns = chrono::duration<double, nano>(finish - begin).count();
+
+    return { stride, order, latency, ns / loads_,
+        (double) loads_ * min(stride, (uint_fast64_t) 64ul) / ns, counters };
+}
+
+vector<StridePoint> StrideAccess::sweep ( DistributionGenerator *generator,
+        const vector<AccessOrder> &orders ) {
+    vector<StridePoint> points;
+    while ( ! generator->is_done() ) {
+        uint_fast64_t stride = generator->next();
+        for ( AccessOrder order : orders ) points.push_back(measure(stride, order));
+    }
+    return points;
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "distribution_generator.hpp"
+#include "threading.hpp"
+#include "topology.hpp"
+
+using namespace std;
+
+// Classes in this file
+class SweepScheduler;
+
+// Resources shared by measurements that must not run at the same time
+enum SchedulingDomain {
+    PACKAGE_DOMAIN,     // One measurement at a time per socket
+    LLC_DOMAIN          // One measurement at a time per last level cache
+};
+
+// Measurement of one size at a placement. placed is false if pinning to its
+// CPU or binding to its node failed (e.g. a CPU excluded by taskset or a
+// cpuset), so that results are not reported with a placement not applied
+typedef function<void(const Placement &placement, uint_fast64_t size,
+        bool placed)> SweepMeasure;
+
+// Record of one measurement run by the scheduler
+struct ScheduledRun {
+    Placement placement;    //Where the measurement ran
+    uint_fast64_t size;     //Size that was measured
+    unsigned domain;        //Index of the domain that ran it
+    bool stolen;            //True if taken from the queue of another domain
+    bool placed;            //False if pinning or memory binding failed
+    double begin;           //Seconds since the start of run
+    double end;
+};
+
+/****************************************************************************/
+// Runs the sizes of several sweeps in parallel across topology domains.
+// Every domain (socket or LLC) has a queue and a worker thread, and the
+// worker runs the measurements of its queue one at a time, so measurements
+// sharing a domain never overlap while different domains run concurrently.
+// A sweep placed on a CPU goes to the queue of the domain of that CPU. A
+// sweep with cpu -1 can run anywhere: its sizes are dealt round robin over
+// the queues, and a worker whose queue is empty steals them from the back of
+// the other queues, running them on its first CPU. A measurement whose
+// memory node belongs to other domains (a remote placement) also waits for
+// those domains to be idle, so that it does not load their memory while they
+// measure. Measurements may write to a shared ResultSink, which is thread
+// safe.
+// Example of use:
+//   SweepScheduler scheduler(Topology::discover(), LLC_DOMAIN);
+//   ResultSink sink("latency.csv");
+//   for ( Placement &placement : topology.placement_matrix(true) )
+//       scheduler.add(DistributionGenerator::make_generator(4096, 1ul<<28,
+//                   EXPONENTIALLY_SPACED, 32), placement,
+//               [&] ( const Placement &where, uint_fast64_t size, bool placed ) {
+//                   /* if placed, measure size and write records with
+//                      where.cpu and where.node */ });
+//   scheduler.run();
+class SweepScheduler {
+    private:
+        // Measurement waiting in a queue
+        struct Task {
+            Placement placement;        //cpu -1 if any domain can run it
+            uint_fast64_t size;
+            const SweepMeasure *measure;
+        };
+
+        Topology topology_;
+        vector<vector<int>> cpus_;      //CPUs of each domain
+        vector<deque<Task>> queues_;    //Waiting measurements of each domain
+        vector<mutex> locks_;           //Lock of each queue
+        vector<mutex> busy_;            //Held by the measurement using
+                                        //each domain
+        vector<SweepMeasure*> measures_;    //Measures of the added sweeps
+        uint_fast64_t next_ = 0;        //Next queue of unplaced sizes
+
+        //Domain of a CPU (0 if unknown)
+        unsigned domain_of ( int cpu ) const;
+        //Domains used by a placement: the domain of its CPU and the domains
+        //of the CPUs of its memory node, sorted
+        vector<unsigned> domains_of ( const Placement &placement ) const;
+        //Takes the next task of a domain, or steals one. Returns false if
+        //there is nothing left to run
+        bool take ( unsigned domain, Task &task, bool &stolen );
+
+    public:
+        //Constructor with the topology of the machine and its domains
+        SweepScheduler ( const Topology &topology = Topology::discover(),
+                SchedulingDomain domain = PACKAGE_DOMAIN );
+        ~SweepScheduler (  );
+        SweepScheduler ( const SweepScheduler & ) = delete;
+        SweepScheduler &operator= ( const SweepScheduler & ) = delete;
+
+        //Number of domains that can run at the same time
+        unsigned domains (  ) const { return queues_.size(); }
+        //Adds every size of a list, measured at a placement
+        void add ( const vector<uint_fast64_t> &sizes, const Placement &placement,
+                const SweepMeasure &measure );
+        //Adds every size provided by the generator (which is deleted)
+        void add ( DistributionGenerator *generator, const Placement &placement,
+                const SweepMeasure &measure );
+        //Runs every added measurement and returns them in completion order.
+        //The first exception thrown by a measurement is rethrown at the end
+        vector<ScheduledRun> run (  );
+};
+
+/****************************************************************************/
+// Method implementations
+
+// Domain discovery
+// Domains are numbered in the order of their ids in the topology
+SweepScheduler::SweepScheduler ( const Topology &topology,
+        SchedulingDomain domain ) :
+    topology_ ( topology ) {
+    vector<int> ids = domain == PACKAGE_DOMAIN ? topology_.packages() :
+        topology_.llc_domains();
+    for ( int id : ids ) {
+        vector<int> cpus;
+        for ( const CpuInfo &info : topology_.cpus() )
+            if ( ( domain == PACKAGE_DOMAIN ? info.package : info.llc ) == id )
+                cpus.push_back(info.id);
+        cpus_.push_back(cpus);
+    }
+    if ( cpus_.empty() ) cpus_.push_back(allowed_cpus());
+    queues_.resize(cpus_.size());
+    locks_ = vector<mutex>(cpus_.size());
+    busy_ = vector<mutex>(cpus_.size());
+}
+
+SweepScheduler::~SweepScheduler (  ) {
+    for ( SweepMeasure *measure : measures_ ) delete measure;
+}
+
+unsigned SweepScheduler::domain_of ( int cpu ) const {
+    for ( unsigned d = 0; d < cpus_.size(); ++d )
+        for ( int member : cpus_[d] ) if ( member == cpu ) return d;
+    return 0;
+}
+
+vector<unsigned> SweepScheduler::domains_of ( const Placement &placement ) const {
+    vector<unsigned> domains = { domain_of(placement.cpu) };
+    for ( int cpu : topology_.cpus_of_node(placement.node) )
+        domains.push_back(domain_of(cpu));
+    sort(domains.begin(), domains.end());
+    domains.erase(unique(domains.begin(), domains.end()), domains.end());
+    return domains;
+}
+
+void SweepScheduler::add ( const vector<uint_fast64_t> &sizes,
+        const Placement &placement, const SweepMeasure &measure ) {
+    measures_.push_back(new SweepMeasure(measure));
+    for ( uint_fast64_t size : sizes ) {
+        unsigned domain = placement.cpu >= 0 ? domain_of(placement.cpu) :
+            next_++ % queues_.size();
+        queues_[domain].push_back( { placement, size, measures_.back() } );
+    }
+}
+
+void SweepScheduler::add ( DistributionGenerator *generator,
+        const Placement &placement, const SweepMeasure &measure ) {
+    vector<uint_fast64_t> sizes;
+    while ( ! generator->is_done() ) sizes.push_back(generator->next());
+    delete generator;
+    add(sizes, placement, measure);
+}
+
+// Work stealing
+// Own tasks are taken from the front, and stolen ones from the back, where
+// the owner is least likely to be working. Placed tasks are never stolen
+bool SweepScheduler::take ( unsigned domain, Task &task, bool &stolen ) {
+    {
+        lock_guard<mutex> lock(locks_[domain]);
+        if ( ! queues_[domain].empty() ) {
+            task = queues_[domain].front();
+            queues_[domain].pop_front();
+            stolen = false;
+            return true;
+        }
+    }
+    for ( unsigned i = 1; i < queues_.size(); ++i ) {
+        unsigned victim = ( domain + i ) % queues_.size();
+        lock_guard<mutex> lock(locks_[victim]);
+        deque<Task> &queue = queues_[victim];
+        for ( auto it = queue.rbegin(); it != queue.rend(); ++it )
+            if ( it->placement.cpu < 0 ) {
+                task = *it;
+                queue.erase(next(it).base());
+                stolen = true;
+                return true;
+            }
+    }
+    return false;
+}
+
+// Parallel execution
+// Workers pin themselves to the CPU of each task and bind their memory to
+// its node (the node of the CPU when the task has none). The domains of a
+// task are held while it runs, locked in increasing order so that workers
+// waiting for each other's domains cannot deadlock
+vector<ScheduledRun> SweepScheduler::run (  ) {
+    vector<ScheduledRun> runs;
+    mutex runs_lock;
+    exception_ptr failure;
+    auto start = chrono::steady_clock::now();
+    auto seconds = [&start] (  ) {
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+
+    vector<thread> workers;
+    for ( unsigned d = 0; d < queues_.size(); ++d )
+        workers.emplace_back( [&, d] (  ) {
+            Task task;
+            bool stolen;
+            while ( take(d, task, stolen) ) {
+                Placement placement = task.placement;
+                if ( placement.cpu < 0 ) placement.cpu = cpus_[d].front();
+                if ( placement.node < 0 )
+                    placement.node = max(topology_.node_of_cpu(placement.cpu), 0);
+                vector<unsigned> domains = domains_of(placement);
+                for ( unsigned domain : domains ) busy_[domain].lock();
+                bool placed = pin_current_thread(placement.cpu) &&
+                    bind_thread_memory(placement.node);
+                ScheduledRun record = { placement, task.size, d, stolen, placed,
+                    seconds(), 0.0 };
+                try {
+                    (*task.measure)(placement, task.size, placed);
+                } catch ( ... ) {
+                    lock_guard<mutex> lock(runs_lock);
+                    if ( ! failure ) failure = current_exception();
+                }
+                unbind_thread_memory();
+                record.end = seconds();
+                for ( unsigned domain : domains ) busy_[domain].unlock();
+                lock_guard<mutex> lock(runs_lock);
+                runs.push_back(record);
+            }
+        } );
+    for ( thread &worker : workers ) worker.join();
+    if ( failure ) rethrow_exception(failure);
+    return runs;
+}
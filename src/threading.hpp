@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <sched.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Classes in this file
+class SpinBarrier;
+
+/****************************************************************************/
+// Barrier used to start and stop timed regions on several threads at once.
+// Waiting threads spin (yielding) instead of sleeping, so they leave the
+// barrier with a small and similar delay.
+// Example of use:
+//   SpinBarrier barrier(4);
+//   //In each of the 4 threads
+//   barrier.wait();
+class SpinBarrier {
+    private:
+        const unsigned threads_;            //Number of threads to wait for
+        atomic<unsigned> waiting_ {0};      //Threads already in the barrier
+        atomic<unsigned> generation_ {0};   //Number of times it was released
+
+    public:
+        //Constructor with the number of threads that meet at the barrier
+        explicit SpinBarrier ( unsigned threads ) : threads_(threads) {  }
+        //Blocks until all threads have called wait
+        void wait (  );
+};
+
+// Returns the CPUs the current process is allowed to run on
+vector<int> allowed_cpus (  );
+// Pins the calling thread to a single CPU. Returns false if not allowed
+bool pin_current_thread ( int cpu );
+
+/****************************************************************************/
+// Method implementations
+
+// Barrier waiting operation
+// The last thread to arrive resets the counter and releases the others by
+// moving to the next generation
+void SpinBarrier::wait (  ) {
+    unsigned generation = generation_.load(memory_order_acquire);
+    if ( waiting_.fetch_add(1, memory_order_acq_rel) + 1 == threads_ ) {
+        waiting_.store(0, memory_order_relaxed);
+        generation_.fetch_add(1, memory_order_release);
+    } else {
+        while ( generation_.load(memory_order_acquire) == generation )
+            this_thread::yield();
+    }
+}
+
+// Reads the affinity mask of the process
+// Falls back to CPU 0 if the mask cannot be read
+vector<int> allowed_cpus (  ) {
+    vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if ( sched_getaffinity(0, sizeof(set), &set) == 0 ) {
+        for ( int cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+            if ( CPU_ISSET(cpu, &set) ) cpus.push_back(cpu);
+    }
+    if ( cpus.empty() ) cpus.push_back(0);
+    return cpus;
+}
+
+// Sets the affinity of the calling thread
+// On Linux, pid 0 refers to the calling thread and not to the whole process
+bool pin_current_thread ( int cpu ) {
+    if ( cpu < 0 || cpu >= CPU_SETSIZE ) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <functional>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define TOPOPERF_TSC 1
+#endif
+
+#include "distribution_generator.hpp"
+#include "perf_counters.hpp"
+
+using namespace std;
+
+// Classes in this file
+class Timer;
+class MeasurementHarness;
+
+// Clocks used to time measurements
+enum ClockSource {
+    TSC,            // Time stamp counter, calibrated against MONOTONIC_RAW
+    MONOTONIC_RAW   // clock_gettime(CLOCK_MONOTONIC_RAW)
+};
+
+// Statistics of the repetitions of one measurement, in ns per operation
+// min, median and p99 use every sample; mean, stddev and the confidence
+// interval use the samples left after outlier rejection
+struct TimingStats {
+    uint_fast64_t samples = 0;  //Number of timed repetitions
+    uint_fast64_t rejected = 0; //Repetitions rejected as outliers
+    double min = 0.0;
+    double median = 0.0;
+    double p99 = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double ci95 = 0.0;          //Half width of the 95% confidence interval
+    CounterValues counters;     //Hardware counters per operation (if any
+                                //are attached to the harness)
+    //Half width of the confidence interval relative to the mean
+    double relative_ci (  ) const { return mean > 0.0 ? ci95 / mean : 0.0; }
+};
+
+// Statistics of one size of a sweep
+struct TimedPoint {
+    uint_fast64_t size;
+    TimingStats stats;
+};
+
+// Returns the current time of CLOCK_MONOTONIC_RAW in ns
+uint_fast64_t monotonic_raw_ns (  );
+// Returns true if the CPU has an invariant TSC (constant rate in all states)
+bool has_invariant_tsc (  );
+// Computes the statistics of samples, rejecting samples further than
+// outlier_threshold median absolute deviations from the median
+TimingStats compute_stats ( vector<double> samples, double outlier_threshold );
+
+/****************************************************************************/
+// Reads a clock and converts its ticks to ns.
+// The TSC is used when it is invariant, after measuring its frequency
+// against CLOCK_MONOTONIC_RAW. Otherwise, CLOCK_MONOTONIC_RAW is used directly.
+// Example of use:
+//   Timer timer;
+//   uint_fast64_t begin = timer.now();
+//   work();
+//   double ns = timer.to_ns(timer.now() - begin);
+class Timer {
+    private:
+        ClockSource source_;
+        double ticks_per_ns_ = 1.0;     //Calibrated TSC frequency in GHz
+
+    public:
+        //Constructor with the preferred clock and the calibration time
+        explicit Timer ( ClockSource source = TSC,
+                uint_fast64_t calibration_ns = 20000000ul );
+        //Clock being used
+        ClockSource source (  ) const { return source_; }
+        //Ticks per ns (the TSC frequency in GHz, or 1)
+        double ticks_per_ns (  ) const { return ticks_per_ns_; }
+        //Current value of the clock
+        uint_fast64_t now (  ) const;
+        //Converts a number of ticks to ns
+        double to_ns ( uint_fast64_t ticks ) const { return ticks / ticks_per_ns_; }
+};
+
+/****************************************************************************/
+// Repeats a measurement until its result is stable.
+// After warm-up runs, the work is timed at least min_repetitions times and
+// then until the 95% confidence interval of the mean (after outlier
+// rejection) is narrower than max_relative_ci, or max_repetitions is reached.
+// Quiet sizes stop early, and noisy sizes get more repetitions.
+// Example of use:
+//   MeasurementHarness harness;
+//   PointerChase chase;
+//   chase.prepare(1 << 20);
+//   TimingStats stats = harness.run([&] (  ) { chase.traverse(); },
+//       chase.loads());
+class MeasurementHarness {
+    private:
+        Timer timer_;
+        uint_fast64_t warmup_;
+        uint_fast64_t min_repetitions_;
+        uint_fast64_t max_repetitions_;
+        double max_relative_ci_;
+        double outlier_threshold_;
+        PerfCounters *counters_ = nullptr;  //Counters around timed repetitions
+
+    public:
+        //Constructor with the number of warm-up runs, the limits on timed
+        //repetitions, the target relative confidence interval, the outlier
+        //threshold (in median absolute deviations) and the clock
+        MeasurementHarness ( uint_fast64_t warmup = 2ul,
+                uint_fast64_t min_repetitions = 5ul,
+                uint_fast64_t max_repetitions = 100ul,
+                double max_relative_ci = 0.01,
+                double outlier_threshold = 5.0,
+                ClockSource source = TSC );
+        //Times work, which performs operations operations per call.
+        //Returns statistics in ns per operation
+        TimingStats run ( const function<void()> &work, double operations = 1.0 );
+        //Runs prepare (not timed) and then work for every size of the
+        //generator. operations gives the number of operations per call of
+        //work for a size
+        vector<TimedPoint> sweep ( DistributionGenerator *generator,
+                const function<void(uint_fast64_t)> &prepare,
+                const function<void(uint_fast64_t)> &work,
+                const function<double(uint_fast64_t)> &operations );
+        //Clock used by the harness
+        const Timer &timer (  ) const { return timer_; }
+        //Counts hardware events over the timed repetitions of every run. The
+        //counters must outlive the harness and belong to the calling thread
+        void attach ( PerfCounters &counters ) { counters_ = &counters; }
+};
+
+/****************************************************************************/
+// Method implementations
+
+uint_fast64_t monotonic_raw_ns (  ) {
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+    return (uint_fast64_t) time.tv_sec * 1000000000ul + time.tv_nsec;
+}
+
+// Invariant TSC detection (CPUID leaf 0x80000007, EDX bit 8)
+bool has_invariant_tsc (  ) {
+#ifdef TOPOPERF_TSC
+    unsigned eax, ebx, ecx, edx;
+    if ( __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) )
+        return ( edx >> 8 ) & 1u;
+#endif
+    return false;
+}
+
+// Two-sided Student t values for 95% confidence, by degrees of freedom
+const double STUDENT_T95[] = { 0.0, 12.706, 4.303, 3.182, 2.776, 2.571,
+    2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131,
+    2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060,
+    2.056, 2.052, 2.048, 2.045, 2.042 };
+
+// Statistics computation
+// Outliers are detected with the median absolute deviation, which is not
+// affected by the outliers themselves
+TimingStats compute_stats ( vector<double> samples, double outlier_threshold ) {
+    TimingStats stats;
+    stats.samples = samples.size();
+    if ( samples.empty() ) return stats;
+    sort(samples.begin(), samples.end());
+    uint_fast64_t n = samples.size();
+    stats.min = samples.front();
+    stats.median = n % 2 ? samples[n / 2] :
+        ( samples[n / 2 - 1] + samples[n / 2] ) / 2.0;
+    stats.p99 = samples[min(n - 1, (uint_fast64_t) ceil(0.99 * n) - 1)];
+
+    vector<double> deviations;
+    for ( double sample : samples ) deviations.push_back(fabs(sample - stats.median));
+    sort(deviations.begin(), deviations.end());
+    double mad = deviations[n / 2];
+
+    vector<double> kept;
+    for ( double sample : samples )
+        if ( mad == 0.0 || fabs(sample - stats.median) <= outlier_threshold * mad )
+            kept.push_back(sample);
+    stats.rejected = n - kept.size();
+
+    double sum = 0.0;
+    for ( double sample : kept ) sum += sample;
+    stats.mean = sum / kept.size();
+    if ( kept.size() > 1 ) {
+        double squares = 0.0;
+        for ( double sample : kept )
+            squares += ( sample - stats.mean ) * ( sample - stats.mean );
+        stats.stddev = sqrt(squares / ( kept.size() - 1 ));
+        uint_fast64_t freedom = kept.size() - 1;
+        double t = freedom <= 30 ? STUDENT_T95[freedom] : 1.96;
+        stats.ci95 = t * stats.stddev / sqrt((double) kept.size());
+    }
+    return stats;
+}
+
+// TSC calibration
+// Counts TSC ticks during calibration_ns of CLOCK_MONOTONIC_RAW. Falls back to
+// CLOCK_MONOTONIC_RAW when the TSC is not invariant
+Timer::Timer ( ClockSource source, uint_fast64_t calibration_ns ) :
+    source_ ( source ) {
+#ifdef TOPOPERF_TSC
+    if ( source_ == TSC && has_invariant_tsc() ) {
+        uint_fast64_t begin_ns = monotonic_raw_ns();
+        uint_fast64_t begin_ticks = __rdtsc();
+        uint_fast64_t end_ns;
+        do end_ns = monotonic_raw_ns(); while ( end_ns - begin_ns < calibration_ns );
+        uint_fast64_t end_ticks = __rdtsc();
+        ticks_per_ns_ = (double) ( end_ticks - begin_ticks ) / ( end_ns - begin_ns );
+        return;
+    }
+#endif
+    source_ = MONOTONIC_RAW;
+}
+
+// Clock reading
+// The TSC is read with rdtscp followed by lfence, so that it is not
+// reordered with the work being timed
+uint_fast64_t Timer::now (  ) const {
+#ifdef TOPOPERF_TSC
+    if ( source_ == TSC ) {
+        unsigned aux;
+        uint_fast64_t ticks = __rdtscp(&aux);
+        _mm_lfence();
+        return ticks;
+    }
+#endif
+    return monotonic_raw_ns();
+}
+
+MeasurementHarness::MeasurementHarness ( uint_fast64_t warmup,
+        uint_fast64_t min_repetitions, uint_fast64_t max_repetitions,
+        double max_relative_ci, double outlier_threshold, ClockSource source ) :
+    timer_ ( source ), warmup_ ( warmup ),
+    min_repetitions_ ( min_repetitions < 2 ? 2ul : min_repetitions ),
+    max_repetitions_ ( max(max_repetitions, min_repetitions_) ),
+    max_relative_ci_ ( max_relative_ci ),
+    outlier_threshold_ ( outlier_threshold ) {  }
+
+// Adaptive repetition
+// Statistics are recomputed after every repetition past the minimum, which
+// is cheap compared to the work being measured. Counters are paused
+// outside the timed work, so they count neither the statistics nor the
+// warm-up, and their counts add up over the repetitions
+TimingStats MeasurementHarness::run ( const function<void()> &work,
+        double operations ) {
+    for ( uint_fast64_t i = 0; i < warmup_; ++i ) work();
+    vector<double> samples;
+    TimingStats stats;
+    if ( counters_ ) {
+        counters_->start();
+        counters_->pause();
+    }
+    while ( samples.size() < max_repetitions_ ) {
+        if ( counters_ ) counters_->resume();
+        uint_fast64_t begin = timer_.now();
+        work();
+        uint_fast64_t end = timer_.now();
+        if ( counters_ ) counters_->pause();
+        samples.push_back(timer_.to_ns(end - begin) / operations);
+        if ( samples.size() < min_repetitions_ ) continue;
+        stats = compute_stats(samples, outlier_threshold_);
+        if ( stats.relative_ci() <= max_relative_ci_ ) break;
+    }
+    if ( counters_ )
+        stats.counters = counters_->stop().per(samples.size() * operations);
+    return stats;
+}
+
+vector<TimedPoint> MeasurementHarness::sweep ( DistributionGenerator *generator,
+        const function<void(uint_fast64_t)> &prepare,
+        const function<void(uint_fast64_t)> &work,
+        const function<double(uint_fast64_t)> &operations ) {
+    vector<TimedPoint> points;
+    while ( ! generator->is_done() ) {
+        uint_fast64_t size = generator->next();
+        prepare(size);
+        points.push_back( { size, run( [&] (  ) { work(size); },
+                    operations(size) ) } );
+    }
+    return points;
+}
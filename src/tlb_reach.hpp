@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <unistd.h>
+
+#include "buffer_arena.hpp"
+#include "distribution_generator.hpp"
+#include "perf_counters.hpp"
+#include "random_engine.hpp"
+
+using namespace std;
+
+// Classes in this file
+class TlbReach;
+
+// Latency of loads spread over a number of pages
+struct TlbPoint {
+    uint_fast64_t pages;        //Number of pages touched (one line each)
+    uint_fast64_t page_size;    //Size of the pages backing the buffer
+    double ns_per_load;         //Average time of one dependent load
+    double ns_control;          //Same loads over the same number of lines,
+                                //packed in as few pages as possible
+    double ns_per_walk;         //Difference of both: the cost of TLB misses
+    CounterValues counters;     //Hardware counters per load of the page
+                                //chain (if counters are attached)
+};
+
+/****************************************************************************/
+// TLB reach and page walk latency.
+// A random dependent chain (as in PointerChase) visits exactly one cache
+// line in each of a number of pages, so the number of TLB entries it needs
+// grows with the pages while its data footprint stays at one line per page.
+// Consecutive pages use consecutive lines of their page (line i of page i,
+// wrapping around), so the lines spread over every cache set instead of
+// competing for the set of the first line of each page.
+// Every measurement is paired with a control chain over the same number of
+// lines packed contiguously, which has the same data cache behavior but
+// touches few pages. The difference of both latencies is the cost of TLB
+// misses: close to 0 while the pages fit in the dTLB, a few cycles while
+// they fit in the STLB, and a page walk beyond. Comparing small pages with
+// huge pages shows the reach that huge pages add.
+// The buffer is a BufferArena of the requested kind of page (which may fall
+// back to smaller pages), sized for the largest number of pages. Attached
+// PerfCounters count the timed page chain (e.g. dTLB misses per load).
+// Example of use:
+//   //Number of pages from 16 to 64 Ki, with 4 KiB and with 2 MiB pages
+//   for ( PageKind kind : { SMALL_PAGES, HUGE_2M } ) {
+//       TlbReach reach(kind);
+//       for ( TlbPoint &point : reach.sweep(DistributionGenerator::make_generator(
+//               16, 65536, EXPONENTIALLY_SPACED, 24)) )
+//           std::cout << point.pages << " " << point.page_size << " "
+//               << point.ns_per_walk << std::endl;
+//   }
+class TlbReach {
+    private:
+        BufferArena *arena_ = nullptr;  //Memory of the chains
+        PageKind kind_;                 //Requested kind of page
+        uint_fast64_t loads_;           //Timed loads per measurement
+        vector<uint32_t> order_;        //Scratch space for the permutation
+        Xoshiro256StarStar engine_;     //Source of the random permutations
+        PerfCounters *counters_ = nullptr;  //Counters around the page chain
+
+        //Builds a random chain over slots lines, one in each block of
+        //spacing bytes
+        void **prepare ( uint_fast64_t slots, uint_fast64_t spacing );
+        //Follows a chain for a number of loads
+        void **chase ( void **start, uint_fast64_t loads ) const;
+        //Times a chain, after an untimed pass. Counts events in counters if
+        //it is not null
+        double time ( void **start, uint_fast64_t slots,
+                CounterValues *counters = nullptr ) const;
+
+    public:
+        //Constructor with the kind of page and the number of dependent
+        //loads timed for each measurement
+        TlbReach ( PageKind kind = SMALL_PAGES, uint_fast64_t loads = 1ul << 20,
+                uint_fast64_t seed = random_seed() );
+        ~TlbReach (  ) { delete arena_; }
+        TlbReach ( const TlbReach & ) = delete;
+        TlbReach &operator= ( const TlbReach & ) = delete;
+
+        //Grows the buffer to hold a number of pages
+        void reserve ( uint_fast64_t pages );
+        //Counts hardware events over the timed page chain of every
+        //measurement. The counters must outlive the object and belong to
+        //the calling thread
+        void attach ( PerfCounters &counters ) { counters_ = &counters; }
+        //Size of the pages of the buffer (0 before the first reserve)
+        uint_fast64_t page_size (  ) const { return arena_ ? arena_->page_size() : 0ul; }
+        //Size of the buffer in bytes (0 before the first reserve)
+        uint_fast64_t size (  ) const { return arena_ ? arena_->size() : 0ul; }
+        //Measures one line per page over a number of pages
+        TlbPoint measure ( uint_fast64_t pages );
+        //Measures every number of pages provided by the generator
+        vector<TlbPoint> sweep ( DistributionGenerator *generator );
+};
+
+/****************************************************************************/
+// Method implementations
+
+TlbReach::TlbReach ( PageKind kind, uint_fast64_t loads, uint_fast64_t seed ) :
+    kind_ ( kind ),
+    // Loads are issued in blocks of 16 by chase
+    loads_ ( ( max(loads, (uint_fast64_t) 16ul) + 15ul ) & ~15ul ),
+    engine_ ( seed ) {  }
+
+// Buffer allocation
+// Only grows. The pages of the arena are known once it is mapped: when it
+// fell back to smaller pages, it is mapped again with the kind obtained and
+// sized for them, instead of keeping pages of the requested size
+void TlbReach::reserve ( uint_fast64_t pages ) {
+    pages = max(pages, (uint_fast64_t) 1ul);
+    if ( arena_ && arena_->size() / arena_->page_size() >= pages ) return;
+    delete arena_;
+    arena_ = nullptr;
+    uint_fast64_t page = kind_ == HUGE_1G ? 1ul << 30 :
+        ( kind_ == SMALL_PAGES ? sysconf(_SC_PAGESIZE) : 1ul << 21 );
+    arena_ = new BufferArena(pages * page, kind_);
+    if ( arena_->page_size() < page ) {
+        uint_fast64_t obtained = arena_->page_size();
+        PageKind kind = arena_->page_kind();
+        delete arena_;
+        arena_ = nullptr;
+        arena_ = new BufferArena(pages * obtained, kind);
+    }
+}
+
+// Chain construction
+// Sattolo's algorithm, as in PointerChase. Slot i is the line i (modulo the
+// lines of a spacing) of the i-th block of spacing bytes
+void **TlbReach::prepare ( uint_fast64_t slots, uint_fast64_t spacing ) {
+    char *base = arena_->view<char>(slots * spacing);
+    uint_fast64_t lines = max(spacing / 64ul, (uint_fast64_t) 1ul);
+    auto slot = [&] ( uint_fast64_t i ) {
+        return (void**) ( base + i * spacing + ( i % lines ) * 64ul );
+    };
+    order_.resize(slots);
+    for ( uint_fast64_t i = 0; i < slots; ++i ) order_[i] = i;
+    for ( uint_fast64_t i = slots - 1; i > 0; --i ) {
+        uniform_int_distribution<uint_fast64_t> pick(0, i - 1);
+        swap(order_[i], order_[pick(engine_)]);
+    }
+    for ( uint_fast64_t i = 0; i < slots; ++i ) *slot(i) = slot(order_[i]);
+    return slot(0);
+}
+
+// Chain traversal
+// Unrolled like PointerChase::chase
+void **TlbReach::chase ( void **start, uint_fast64_t loads ) const {
+    void **p = start;
+    for ( uint_fast64_t i = 0; i < loads; i += 16ul ) {
+        p = (void**) *p; p = (void**) *p; p = (void**) *p; p = (void**) *p;
+        p = (void**) *p; p = (void**) *p; p = (void**) *p; p = (void**) *p;
+        p = (void**) *p; p = (void**) *p; p = (void**) *p; p = (void**) *p;
+        p = (void**) *p; p = (void**) *p; p = (void**) *p; p = (void**) *p;
+    }
+    return p;
+}
+
+double TlbReach::time ( void **start, uint_fast64_t slots,
+        CounterValues *counters ) const {
+    start = chase(start, min(( slots + 15ul ) & ~15ul, loads_));
+    if ( counters && counters_ ) counters_->start();
+    auto begin = chrono::steady_clock::now();
+    void ** volatile end = chase(start, loads_);
+    auto finish = chrono::steady_clock::now();
+    (void) end;
+    if ( counters && counters_ ) *counters = counters_->stop().per(loads_);
+    return chrono::duration<double, nano>(finish - begin).count() / loads_;
+}
+
+// TLB measurement
+// The control chain is built in the same memory after the page chain was
+// timed, so both use the same physical pages for their first lines
+TlbPoint TlbReach::measure ( uint_fast64_t pages ) {
+    pages = max(pages, (uint_fast64_t) 1ul);
+    reserve(pages);
+    uint_fast64_t page = arena_->page_size();
+    CounterValues counters;
+    double spread = time(prepare(pages, page), pages, &counters);
+    double packed = time(prepare(pages, 64ul), pages);
+    return { pages, page, spread, packed, spread - packed, counters };
+}
+
+// Sweep over the numbers of pages of a generator
+// The buffer is allocated only once, for the largest number
+vector<TlbPoint> TlbReach::sweep ( DistributionGenerator *generator ) {
+    vector<uint_fast64_t> counts;
+    while ( ! generator->is_done() ) counts.push_back(generator->next());
+    if ( ! counts.empty() ) reserve(*max_element(counts.begin(), counts.end()));
+
+    vector<TlbPoint> points;
+    for ( uint_fast64_t pages : counts ) points.push_back(measure(pages));
+    return points;
+}
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "threading.hpp"
+
+using namespace std;
+
+// Classes in this file
+class Topology;
+
+// Description of one logical CPU
+struct CpuInfo {
+    int id;         //Logical CPU number used by the scheduler
+    int core;       //Physical core id inside its package
+    int package;    //Socket (physical package) id
+    int node;       //NUMA node of the CPU
+    int llc;        //Last level cache domain (lowest CPU sharing the LLC)
+    uint_fast64_t llc_size;     //Bytes of the last level cache (0 if unknown)
+};
+
+// Executing CPU and memory node of a measurement
+struct Placement {
+    int cpu;        //CPU running the measurement
+    int node;       //NUMA node holding the measured memory
+};
+
+// Parses a sysfs CPU or node list such as "0-3,8,10-11"
+vector<int> parse_cpu_list ( const string &list );
+// Binds the pages of a buffer to a NUMA node, moving pages already touched
+bool bind_memory ( void *address, uint_fast64_t size, int node );
+// Makes the calling thread allocate new pages only on a NUMA node
+bool bind_thread_memory ( int node );
+// Restores the default (first touch) policy for the calling thread
+bool unbind_thread_memory (  );
+// Runs a function in a thread pinned to placement.cpu whose memory is
+// allocated on placement.node. Returns false if the placement failed
+bool run_placed ( const Placement &placement, const function<void()> &work );
+
+/****************************************************************************/
+// Machine topology discovered from sysfs, without external libraries.
+// CPUs come from /sys/devices/system/cpu and NUMA nodes from
+// /sys/devices/system/node. Nodes without CPUs (e.g. CXL or HBM memory) are
+// kept as memory nodes. Machines without NUMA information are seen as a
+// single node 0.
+// Example of use:
+//   Topology topology = Topology::discover();
+//   //Latency from every node to every node
+//   for ( Placement &placement : topology.placement_matrix() )
+//       run_placed(placement, [&] (  ) { /* allocate and measure */ });
+class Topology {
+    private:
+        vector<CpuInfo> cpus_;      //Online CPUs, sorted by id
+        vector<int> nodes_;         //Online NUMA nodes, with or without CPUs
+
+        //Reads the first integer of a sysfs file, or fallback
+        static int read_int ( const string &path, int fallback );
+        //Reads the first line of a sysfs file
+        static string read_line ( const string &path );
+        //Reads a sysfs size such as "32768K" in bytes, or 0
+        static uint_fast64_t read_size ( const string &path );
+
+    public:
+        //Discovers the topology under a sysfs root (useful for testing)
+        static Topology discover ( const string &root = "/sys/devices/system" );
+
+        //Online CPUs
+        const vector<CpuInfo> &cpus (  ) const { return cpus_; }
+        //Online NUMA nodes, including memory nodes without CPUs
+        const vector<int> &nodes (  ) const { return nodes_; }
+        //CPUs of a NUMA node
+        vector<int> cpus_of_node ( int node ) const;
+        //CPUs of a package (socket)
+        vector<int> cpus_of_package ( int package ) const;
+        //NUMA node of a CPU (-1 if unknown)
+        int node_of_cpu ( int cpu ) const;
+        //Distinct packages
+        vector<int> packages (  ) const;
+        //Distinct last level cache domains
+        vector<int> llc_domains (  ) const;
+        //Bytes of the largest last level cache (0 if unknown)
+        uint_fast64_t largest_llc (  ) const;
+        //Pairs of (executing CPU, memory node) over every node, including
+        //memory nodes without CPUs. With every_cpu false, only the first CPU
+        //of each node with CPUs is used as executing CPU
+        vector<Placement> placement_matrix ( bool every_cpu = false ) const;
+};
+
+/****************************************************************************/
+// Method implementations
+
+// CPU list parsing
+// Ranges are inclusive, and empty strings give empty lists
+vector<int> parse_cpu_list ( const string &list ) {
+    vector<int> cpus;
+    stringstream stream(list);
+    string range;
+    while ( getline(stream, range, ',') ) {
+        if ( range.empty() || range == "\n" ) continue;
+        size_t dash = range.find('-');
+        int first = stoi(range.substr(0, dash));
+        int last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+        for ( int cpu = first; cpu <= last; ++cpu ) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// Memory policies of the Linux kernel (from linux/mempolicy.h), defined here
+// to avoid a dependency on libnuma
+const int TOPOPERF_MPOL_DEFAULT = 0;
+const int TOPOPERF_MPOL_BIND = 2;
+const unsigned TOPOPERF_MPOL_MF_MOVE = 1u << 1;
+
+// Returns the node mask of a single node, sized to hold it
+vector<unsigned long> node_mask ( int node ) {
+    const int bits = 8 * sizeof(unsigned long);
+    vector<unsigned long> mask(node / bits + 1, 0ul);
+    mask[node / bits] = 1ul << ( node % bits );
+    return mask;
+}
+
+// Buffer binding
+// The range is extended to whole pages, as required by mbind. The kernel
+// reads maxnode - 1 bits of the mask, so maxnode is one more than its bits
+bool bind_memory ( void *address, uint_fast64_t size, int node ) {
+    if ( node < 0 ) return false;
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t begin = (uintptr_t) address & ~(page - 1);
+    uintptr_t end = ((uintptr_t) address + size + page - 1) & ~(page - 1);
+    vector<unsigned long> mask = node_mask(node);
+    return syscall(SYS_mbind, begin, end - begin, TOPOPERF_MPOL_BIND, mask.data(),
+            8ul * sizeof(unsigned long) * mask.size() + 1ul,
+            TOPOPERF_MPOL_MF_MOVE) == 0;
+}
+
+// Thread binding
+// Affects pages touched for the first time by this thread and by the threads
+// it creates afterwards
+bool bind_thread_memory ( int node ) {
+    if ( node < 0 ) return false;
+    vector<unsigned long> mask = node_mask(node);
+    return syscall(SYS_set_mempolicy, TOPOPERF_MPOL_BIND, mask.data(),
+            8ul * sizeof(unsigned long) * mask.size() + 1ul) == 0;
+}
+
+bool unbind_thread_memory (  ) {
+    return syscall(SYS_set_mempolicy, TOPOPERF_MPOL_DEFAULT, nullptr, 0ul) == 0;
+}
+
+// Placed execution
+// A new thread is used so that the caller keeps its affinity and policy
+bool run_placed ( const Placement &placement, const function<void()> &work ) {
+    bool placed = false;
+    thread worker( [&] (  ) {
+        placed = pin_current_thread(placement.cpu) &&
+            bind_thread_memory(placement.node);
+        if ( placed ) work();
+    } );
+    worker.join();
+    return placed;
+}
+
+int Topology::read_int ( const string &path, int fallback ) {
+    ifstream file(path);
+    int value;
+    if ( file >> value ) return value;
+    return fallback;
+}
+
+string Topology::read_line ( const string &path ) {
+    ifstream file(path);
+    string line;
+    getline(file, line);
+    return line;
+}
+
+// Sizes of caches have a K suffix, and are read as powers of 1024
+uint_fast64_t Topology::read_size ( const string &path ) {
+    ifstream file(path);
+    uint_fast64_t value;
+    char unit = ' ';
+    if ( ! ( file >> value ) ) return 0ul;
+    file >> unit;
+    if ( unit == 'K' ) value <<= 10;
+    else if ( unit == 'M' ) value <<= 20;
+    else if ( unit == 'G' ) value <<= 30;
+    return value;
+}
+
+// Topology discovery
+// The LLC of a CPU is the cache index with the highest level, identified by
+// the lowest CPU in its shared_cpu_list
+Topology Topology::discover ( const string &root ) {
+    Topology topology;
+    string cpu_root = root + "/cpu/";
+    vector<int> online = parse_cpu_list(read_line(cpu_root + "online"));
+    if ( online.empty() ) online = allowed_cpus();
+
+    map<int, int> node_of;
+    set<int> nodes;
+    for ( int node : parse_cpu_list(read_line(root + "/node/online")) ) {
+        nodes.insert(node);
+        string list = read_line(root + "/node/node" + to_string(node) + "/cpulist");
+        for ( int cpu : parse_cpu_list(list) ) node_of[cpu] = node;
+    }
+
+    for ( int cpu : online ) {
+        string base = cpu_root + "cpu" + to_string(cpu) + "/";
+        CpuInfo info;
+        info.id = cpu;
+        info.core = read_int(base + "topology/core_id", cpu);
+        info.package = read_int(base + "topology/physical_package_id", 0);
+        info.node = node_of.count(cpu) ? node_of[cpu] : 0;
+        info.llc = cpu;
+        info.llc_size = 0;
+        int llc_level = 0;
+        for ( int index = 0; ; ++index ) {
+            string cache = base + "cache/index" + to_string(index) + "/";
+            int level = read_int(cache + "level", -1);
+            if ( level < 0 ) break;
+            if ( read_line(cache + "type") == "Instruction" ) continue;
+            vector<int> shared = parse_cpu_list(read_line(cache + "shared_cpu_list"));
+            if ( level > llc_level && ! shared.empty() ) {
+                llc_level = level;
+                info.llc = *min_element(shared.begin(), shared.end());
+                info.llc_size = read_size(cache + "size");
+            }
+        }
+        topology.cpus_.push_back(info);
+    }
+
+    for ( const CpuInfo &info : topology.cpus_ ) nodes.insert(info.node);
+    topology.nodes_.assign(nodes.begin(), nodes.end());
+    return topology;
+}
+
+vector<int> Topology::cpus_of_node ( int node ) const {
+    vector<int> cpus;
+    for ( const CpuInfo &info : cpus_ )
+        if ( info.node == node ) cpus.push_back(info.id);
+    return cpus;
+}
+
+vector<int> Topology::cpus_of_package ( int package ) const {
+    vector<int> cpus;
+    for ( const CpuInfo &info : cpus_ )
+        if ( info.package == package ) cpus.push_back(info.id);
+    return cpus;
+}
+
+int Topology::node_of_cpu ( int cpu ) const {
+    for ( const CpuInfo &info : cpus_ )
+        if ( info.id == cpu ) return info.node;
+    return -1;
+}
+
+vector<int> Topology::packages (  ) const {
+    set<int> packages;
+    for ( const CpuInfo &info : cpus_ ) packages.insert(info.package);
+    return vector<int>(packages.begin(), packages.end());
+}
+
+vector<int> Topology::llc_domains (  ) const {
+    set<int> domains;
+    for ( const CpuInfo &info : cpus_ ) domains.insert(info.llc);
+    return vector<int>(domains.begin(), domains.end());
+}
+
+uint_fast64_t Topology::largest_llc (  ) const {
+    uint_fast64_t largest = 0;
+    for ( const CpuInfo &info : cpus_ ) largest = max(largest, info.llc_size);
+    return largest;
+}
+
+// Placement matrix
+// Rows are executing CPUs and columns are memory nodes. Memory nodes without
+// CPUs only appear as columns
+vector<Placement> Topology::placement_matrix ( bool every_cpu ) const {
+    vector<int> executing;
+    if ( every_cpu ) {
+        for ( const CpuInfo &info : cpus_ ) executing.push_back(info.id);
+    } else {
+        for ( int node : nodes_ ) {
+            vector<int> cpus = cpus_of_node(node);
+            if ( ! cpus.empty() ) executing.push_back(cpus.front());
+        }
+    }
+    vector<Placement> matrix;
+    for ( int cpu : executing )
+        for ( int node : nodes_ ) matrix.push_back( { cpu, node } );
+    return matrix;
+}
@@ -0,0 +1,655 @@
+// Command-line driver of the topoperf measurements
+// Build: g++ -O2 -std=c++11 -pthread src/topoperf.cpp -o topoperf
+// Usage: topoperf <command> [options]
+//   latency     Pointer chase latency of every size of the generator
+//   bandwidth   Bandwidth of streaming kernels for every size of the generator
+//   stride      Latency and bandwidth of the strides of the generator (the
+//               sizes are strides, over a buffer of --buffer bytes)
+//   io          File read bandwidth (mmap, read, pread) with cold and warm
+//               page cache, and page fault costs of memory and of mapped
+//               files, for every size
+//   tlb         Latency of one line per page over the numbers of pages of
+//               the generator, with 4 KiB and huge pages (or --pages)
+//   sweep       Prints the sizes of the generator without measuring
+//   full        Characterizes the host within a time budget (--budget)
+// Sizes accept K, M and G suffixes (powers of 1024). Results are written
+// with ResultSink, to the standard output by default. With --cache, measured
+// points are kept in a ResultCache, and later runs only measure the points
+// that are missing from it.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+#include "bandwidth.hpp"
+#include "boundary_detection.hpp"
+#include "buffer_arena.hpp"
+#include "core_to_core.hpp"
+#include "distribution_generator.hpp"
+#include "file_io.hpp"
+#include "loaded_latency.hpp"
+#include "perf_counters.hpp"
+#include "pointer_chase.hpp"
+#include "random_access.hpp"
+#include "result_cache.hpp"
+#include "result_sink.hpp"
+#include "stride_access.hpp"
+#include "sweep_scheduler.hpp"
+#include "timing.hpp"
+#include "tlb_reach.hpp"
+#include "topology.hpp"
+
+const char *USAGE =
+    "Usage: topoperf <latency|bandwidth|stride|io|tlb|sweep|full> [options]\n"
+    "  --generator <kind>   average_point, uniformly_spaced, exponentially_spaced,\n"
+    "                       mid_point, uniformly_random or exponentially_random\n"
+    "                       (default: exponentially_spaced)\n"
+    "  --min <size>         Lower limit of the sizes (default: 4K)\n"
+    "  --max <size>         Upper limit of the sizes (default: 256M)\n"
+    "  --count <n>          Number of sizes (count_limit, default: 32)\n"
+    "  --seed <n>           Seed of random generators\n"
+    "  --align <size>       Rounds sizes to multiples of size (e.g. 4K for pages)\n"
+    "  --pages <kind>       Measure in a pre-faulted arena of 4k, thp, 2m or 1g pages\n"
+    "  --threads <n>        Threads of bandwidth measurements (default: all CPUs)\n"
+    "  --kernels <list>     Bandwidth kernels: read, write, copy, triad, rmw,\n"
+    "                       stream_write or stream_copy, separated by commas\n"
+    "                       (default: read,write,copy,triad)\n"
+    "  --flush              Adds the cost of flushing dirty lines to bandwidth results\n"
+    "  --buffer <size>      Buffer of stride measurements (default: 64M)\n"
+    "  --directory <path>   Directory of the file of io measurements\n"
+    "                       (default: TMPDIR or /tmp)\n"
+    "  --counters           Adds hardware counter records to latency, stride\n"
+    "                       and tlb results (single-thread measurements)\n"
+    "  --budget <seconds>   Time budget of the full characterization (default: 300)\n"
+    "  --output <path>      Result file (default: -, the standard output)\n"
+    "  --cache <path>       Reuses the points measured by previous runs, and\n"
+    "                       keeps the new ones, in a cache file\n"
+    "  --refresh            Measures again the points of this host in the cache\n"
+    "  --format <format>    csv, jsonl or bin (default: csv)\n";
+
+// Options of a command line, with their defaults
+struct Options {
+    string command;
+    Generators generator = EXPONENTIALLY_SPACED;
+    uint_fast64_t min = 4096ul;
+    uint_fast64_t max = 256ul << 20;
+    uint_fast64_t count = 32ul;
+    uint_fast64_t seed = random_seed();
+    uint_fast64_t alignment = 1ul;
+    bool arena = false;
+    PageKind pages = SMALL_PAGES;
+    unsigned threads = thread::hardware_concurrency();
+    vector<BandwidthKernel> kernels = { READ, WRITE, COPY, TRIAD };
+    uint_fast64_t buffer = 64ul << 20;
+    string directory;
+    bool counters = false;
+    bool flush = false;
+    double budget = 300.0;
+    string output = "-";
+    string cache;
+    bool refresh = false;
+    ResultFormat format = CSV;
+};
+
+// Parses a size with an optional K, M or G suffix
+uint_fast64_t parse_size ( const string &text ) {
+    size_t end = 0;
+    uint_fast64_t value = stoull(text, &end);
+    string suffix = text.substr(end);
+    if ( suffix == "K" || suffix == "k" ) return value << 10;
+    else if ( suffix == "M" || suffix == "m" ) return value << 20;
+    else if ( suffix == "G" || suffix == "g" ) return value << 30;
+    else if ( ! suffix.empty() ) throw invalid_argument("bad size " + text);
+    return value;
+}
+
+// Parses the command line. Throws invalid_argument on unknown options
+Options parse_options ( int argc, char **argv ) {
+    Options options;
+    if ( argc < 2 ) throw invalid_argument("missing command");
+    options.command = argv[1];
+    for ( int i = 2; i < argc; ++i ) {
+        string option = argv[i];
+        if ( option == "--counters" ) { options.counters = true; continue; }
+        if ( option == "--flush" ) { options.flush = true; continue; }
+        if ( option == "--refresh" ) { options.refresh = true; continue; }
+        if ( i + 1 >= argc ) throw invalid_argument("missing value of " + option);
+        string value = argv[++i];
+        if ( option == "--generator" ) {
+            if ( ! generator_from_name(value, options.generator) )
+                throw invalid_argument("unknown generator " + value);
+        } else if ( option == "--min" ) options.min = parse_size(value);
+        else if ( option == "--max" ) options.max = parse_size(value);
+        else if ( option == "--buffer" ) options.buffer = parse_size(value);
+        else if ( option == "--count" ) options.count = stoull(value);
+        else if ( option == "--seed" ) options.seed = stoull(value);
+        else if ( option == "--align" )
+            options.alignment = max(parse_size(value), (uint_fast64_t) 1ul);
+        else if ( option == "--threads" ) options.threads = stoul(value);
+        else if ( option == "--budget" ) options.budget = stod(value);
+        else if ( option == "--output" ) options.output = value;
+        else if ( option == "--cache" ) options.cache = value;
+        else if ( option == "--directory" ) options.directory = value;
+        else if ( option == "--pages" ) {
+            map<string, PageKind> kinds = { { "4k", SMALL_PAGES },
+                { "thp", TRANSPARENT_HUGE }, { "2m", HUGE_2M }, { "1g", HUGE_1G } };
+            if ( ! kinds.count(value) ) throw invalid_argument("unknown pages " + value);
+            options.arena = true;
+            options.pages = kinds[value];
+        } else if ( option == "--format" ) {
+            map<string, ResultFormat> formats = { { "csv", CSV },
+                { "jsonl", JSON_LINES }, { "bin", BINARY } };
+            if ( ! formats.count(value) ) throw invalid_argument("unknown format " + value);
+            options.format = formats[value];
+        } else if ( option == "--kernels" ) {
+            options.kernels.clear();
+            stringstream list(value);
+            string name;
+            while ( getline(list, name, ',') ) {
+                int kernel = READ;
+                while ( kernel <= STREAM_COPY && kernel_name((BandwidthKernel) kernel) != name )
+                    ++kernel;
+                if ( kernel > STREAM_COPY ) throw invalid_argument("unknown kernel " + name);
+                options.kernels.push_back((BandwidthKernel) kernel);
+            }
+        } else throw invalid_argument("unknown option " + option);
+    }
+    return options;
+}
+
+// Returns a record with the context shared by every result of a run
+ResultRecord make_record ( Generators generator, uint_fast64_t size,
+        const string &metric, double value, uint_fast64_t page_size,
+        unsigned threads = 1u ) {
+    ResultRecord record;
+    record.generator = generator;
+    record.size = size;
+    record.threads = threads;
+    record.metric = metric;
+    record.value = record.min = record.median = record.p99 = value;
+    record.page_size = page_size;
+    return record;
+}
+
+// Returns the cache key of a point of a sweep
+CacheKey make_key ( const string &kernel, Generators generator,
+        uint_fast64_t min, uint_fast64_t max, uint_fast64_t count,
+        uint_fast64_t size ) {
+    CacheKey key;
+    key.kernel = kernel;
+    key.generator = generator;
+    key.min = min;
+    key.max = max;
+    key.count_limit = count;
+    key.size = size;
+    return key;
+}
+
+// Returns the cache key of a point of the sweep of the options. Settings
+// that change the results of a kernel are part of its name
+CacheKey make_key ( const Options &options, string kernel, uint_fast64_t size,
+        uint_fast64_t page_size ) {
+    if ( options.arena ) kernel += "_pages" + to_string(page_size);
+    return make_key(kernel, options.generator, options.min, options.max,
+            options.count, size);
+}
+
+// Physical memory of the host in bytes
+uint_fast64_t physical_memory (  ) {
+    return (uint_fast64_t) sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+}
+
+// Removes the bandwidth sizes whose arrays (3 per thread) would take more
+// than memory bytes. Returns how many were removed
+uint_fast64_t fit_bandwidth ( vector<uint_fast64_t> &sizes, unsigned threads,
+        uint_fast64_t memory ) {
+    uint_fast64_t limit = memory / ( 3ul * threads );
+    uint_fast64_t before = sizes.size();
+    sizes.erase(remove_if(sizes.begin(), sizes.end(),
+                [&] ( uint_fast64_t size ) { return size > limit; }), sizes.end());
+    return before - sizes.size();
+}
+
+// Latency of every size of the generator, with adaptive repetitions
+void run_latency ( const Options &options, ResultCache &cache, ResultSink &sink ) {
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            options.min, options.max, options.generator, options.count,
+            options.seed, options.alignment);
+    PointerChase chase;
+    BufferArena *arena = nullptr;
+    if ( options.arena ) {
+        arena = new BufferArena(*generator, options.pages);
+        chase.attach(*arena);
+    }
+    uint_fast64_t page_size = arena ? arena->page_size() : sysconf(_SC_PAGESIZE);
+    MeasurementHarness harness;
+    PerfCounters counters;
+    if ( options.counters ) harness.attach(counters);
+    string kernel = options.counters ? "latency_counters" : "latency";
+
+    while ( ! generator->is_done() ) {
+        uint_fast64_t size = generator->next();
+        CacheKey key = make_key(options, kernel, size, page_size);
+        for ( const ResultRecord &record : cache.fetch(key, [&] (  ) {
+                    chase.prepare(size);
+                    TimingStats stats = harness.run( [&] (  ) { chase.traverse(); },
+                            chase.loads());
+                    ResultRecord record = make_record(options.generator, size,
+                            "latency_ns", stats.mean, page_size);
+                    record.set_stats(stats);
+                    vector<ResultRecord> records = counter_records(record, stats);
+                    records.insert(records.begin(), record);
+                    return records;
+                }) )
+            sink.write(record);
+    }
+    delete generator;
+    delete arena;
+}
+
+// Bandwidth of every size of the generator for the selected kernels
+// Arrays are reserved at the largest size first, as in BandwidthEngine::sweep.
+// Sizes whose arrays would take more than half of the memory are skipped
+void run_bandwidth ( const Options &options, ResultCache &cache, ResultSink &sink ) {
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            options.min, options.max, options.generator, options.count,
+            options.seed, options.alignment);
+    vector<uint_fast64_t> sizes = generator->generate_n(options.count);
+    delete generator;
+    BandwidthEngine engine(options.threads);
+    if ( uint_fast64_t skipped = fit_bandwidth(sizes, engine.threads(),
+                physical_memory() / 2) )
+        cerr << "bandwidth: " << skipped << " sizes skipped, their arrays do "
+            "not fit in memory" << endl;
+    BufferArena *arena = nullptr;
+    if ( options.arena && ! sizes.empty() ) {
+        arena = new BufferArena(3ul * engine.threads() *
+                *max_element(sizes.begin(), sizes.end()), options.pages);
+        engine.attach(*arena);
+    }
+    uint_fast64_t page_size = arena ? arena->page_size() : sysconf(_SC_PAGESIZE);
+    if ( ! sizes.empty() ) engine.reserve(*max_element(sizes.begin(), sizes.end()));
+    string threads = "_t" + to_string(engine.threads());
+
+    for ( uint_fast64_t size : sizes )
+        for ( BandwidthKernel kernel : options.kernels ) {
+            string metric = "bandwidth_" + kernel_name(kernel) + "_gbps";
+            CacheKey key = make_key(options, "bandwidth_" + kernel_name(kernel) +
+                    threads, size, page_size);
+            for ( const ResultRecord &record : cache.fetch(key, [&] (  ) {
+                        return vector<ResultRecord>{ make_record(options.generator,
+                                size, metric, engine.measure(kernel, size),
+                                page_size, engine.threads()) };
+                    }) )
+                sink.write(record);
+        }
+    if ( ! options.flush ) {
+        delete arena;
+        return;
+    }
+    for ( uint_fast64_t size : sizes )
+        for ( FlushInstruction instruction : { CLFLUSH, CLFLUSHOPT, CLWB } ) {
+            if ( ! flush_supported(instruction) ) continue;
+            string metric = "flush_" + flush_name(instruction) + "_ns";
+            CacheKey key = make_key(options, "flush_" + flush_name(instruction),
+                    size, page_size);
+            for ( const ResultRecord &record : cache.fetch(key, [&] (  ) {
+                        return vector<ResultRecord>{ make_record(options.generator,
+                                size, metric, engine.measure_flush(instruction, size),
+                                page_size) };
+                    }) )
+                sink.write(record);
+        }
+    delete arena;
+}
+
+// Latency and bandwidth of every stride of the generator, in both orders
+void run_stride ( const Options &options, ResultCache &cache, ResultSink &sink ) {
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            options.min, options.max, options.generator, options.count,
+            options.seed, options.alignment);
+    StrideAccess access(options.buffer);
+    PerfCounters counters;
+    if ( options.counters ) access.attach(counters);
+    string suffix = options.counters ? "_counters" : "";
+    uint_fast64_t page_size = sysconf(_SC_PAGESIZE);
+    while ( ! generator->is_done() ) {
+        uint_fast64_t stride = generator->next();
+        for ( AccessOrder order : { FORWARD, SHUFFLED } ) {
+            string prefix = "stride_" + access_order_name(order);
+            CacheKey key = make_key(options, prefix + "_b" +
+                    to_string(options.buffer) + suffix, stride, page_size);
+            for ( const ResultRecord &record : cache.fetch(key, [&] (  ) {
+                        StridePoint point = access.measure(stride, order);
+                        ResultRecord latency = make_record(options.generator,
+                                point.stride, prefix + "_latency_ns",
+                                point.ns_per_load, page_size);
+                        vector<ResultRecord> records = counter_records(latency,
+                                point.counters, prefix + "_");
+                        records.insert(records.begin(), { latency,
+                                make_record(options.generator, point.stride,
+                                    prefix + "_gbps", point.gb_per_s, page_size) });
+                        return records;
+                    }) )
+                sink.write(record);
+        }
+    }
+    delete generator;
+}
+
+// File read bandwidth of every size of the generator, in every way and page
+// cache state, then the page fault costs of every size, in new memory and in
+// a mapping of the file. Points of the file are cached per device of its
+// file system, so another --directory may measure them again
+void run_io ( const Options &options, ResultCache &cache, ResultSink &sink ) {
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            options.min, options.max, options.generator, options.count,
+            options.seed, options.alignment);
+    vector<uint_fast64_t> sizes = generator->generate_n(options.count);
+    delete generator;
+    FileIo io(options.directory);
+    if ( ! sizes.empty() ) io.reserve(*max_element(sizes.begin(), sizes.end()));
+    uint_fast64_t page_size = sysconf(_SC_PAGESIZE);
+    string device = "_d" + to_string(io.device());
+
+    for ( uint_fast64_t size : sizes )
+        for ( CacheState state : { COLD_CACHE, WARM_CACHE } )
+            for ( FileAccess access : { MMAP_READ, MMAP_SEQUENTIAL, MMAP_WILLNEED,
+                    READ_CALL, PREAD_CALL } ) {
+                string prefix = "io_" + file_access_name(access) + "_" +
+                    cache_state_name(state);
+                CacheKey key = make_key(options, prefix + device, size, page_size);
+                for ( const ResultRecord &record : cache.fetch(key, [&] (  ) {
+                            FileIoPoint point = io.measure(access, state, size);
+                            return vector<ResultRecord>{
+                                make_record(options.generator, size,
+                                        prefix + "_gbps", point.gb_per_s, page_size),
+                                make_record(options.generator, size,
+                                        prefix + "_resident", point.resident,
+                                        page_size) };
+                        }) )
+                    sink.write(record);
+            }
+
+    for ( uint_fast64_t size : sizes )
+        for ( PageKind kind : { SMALL_PAGES, TRANSPARENT_HUGE, HUGE_2M } ) {
+            CacheKey key = make_key(options, "fault_" + page_kind_name(kind),
+                    size, page_size);
+            for ( const ResultRecord &record : cache.fetch(key, [&] (  ) {
+                        PageFaultPoint point = io.measure_faults(kind, size);
+                        return vector<ResultRecord>{ make_record(options.generator,
+                                size, "fault_" + page_kind_name(kind) + "_ns",
+                                point.ns_per_fault, point.page_size) };
+                    }) )
+                sink.write(record);
+        }
+
+    for ( uint_fast64_t size : sizes )
+        for ( PageKind kind : { SMALL_PAGES, TRANSPARENT_HUGE } ) {
+            string prefix = "fault_file_" + page_kind_name(kind);
+            CacheKey key = make_key(options, prefix + device, size, page_size);
+            for ( const ResultRecord &record : cache.fetch(key, [&] (  ) {
+                        PageFaultPoint point = io.measure_faults(kind, size, MAPPED_FILE);
+                        return vector<ResultRecord>{ make_record(options.generator,
+                                size, prefix + "_ns", point.ns_per_fault,
+                                point.page_size) };
+                    }) )
+                sink.write(record);
+        }
+}
+
+// Latency of one line per page for every number of pages of the generator,
+// next to the control chain over as many contiguous lines. Numbers of pages
+// whose buffer would take more than half of the memory are skipped
+void run_tlb ( const Options &options, ResultCache &cache, ResultSink &sink ) {
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            options.min, options.max, options.generator, options.count,
+            options.seed, options.alignment);
+    vector<uint_fast64_t> counts = generator->generate_n(options.count);
+    delete generator;
+    uint_fast64_t memory = physical_memory();
+    vector<PageKind> kinds = { SMALL_PAGES, HUGE_2M };
+    if ( options.arena ) kinds = { options.pages };
+    PerfCounters counters;
+    string suffix = options.counters ? "_counters" : "";
+
+    for ( PageKind kind : kinds ) {
+        uint_fast64_t nominal = kind == SMALL_PAGES ? sysconf(_SC_PAGESIZE) :
+            ( kind == HUGE_1G ? 1ul << 30 : 1ul << 21 );
+        vector<uint_fast64_t> fitting;
+        for ( uint_fast64_t pages : counts )
+            if ( pages > 0 && pages <= memory / 2 / nominal ) fitting.push_back(pages);
+        if ( fitting.empty() ) continue;
+        TlbReach reach(kind, 1ul << 20, options.seed);
+        if ( options.counters ) reach.attach(counters);
+        reach.reserve(*max_element(fitting.begin(), fitting.end()));
+        string prefix = "tlb_" + page_kind_name(kind) + suffix;
+        for ( uint_fast64_t pages : fitting ) {
+            CacheKey key = make_key(prefix, options.generator, options.min,
+                    options.max, options.count, pages);
+            for ( const ResultRecord &record : cache.fetch(key, [&] (  ) {
+                        TlbPoint point = reach.measure(pages);
+                        ResultRecord latency = make_record(options.generator,
+                                pages, "tlb_ns", point.ns_per_load, point.page_size);
+                        vector<ResultRecord> records = counter_records(latency,
+                                point.counters, "tlb_");
+                        records.insert(records.begin(), { latency,
+                            make_record(options.generator, pages, "tlb_control_ns",
+                                    point.ns_control, point.page_size),
+                            make_record(options.generator, pages, "tlb_walk_ns",
+                                    point.ns_per_walk, point.page_size) });
+                        return records;
+                    }) )
+                sink.write(record);
+        }
+    }
+}
+
+// Sizes of the generator, without measurements
+void run_sweep ( const Options &options ) {
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            options.min, options.max, options.generator, options.count,
+            options.seed, options.alignment);
+    for ( uint_fast64_t size : generator->generate_n(options.count) )
+        cout << size << endl;
+    delete generator;
+}
+
+// Full characterization
+// Phases run in order, each one until a share of the budget (unused time is
+// left to the next phases). Sizes are measured one at a time, so a phase
+// stops at its deadline, keeping the results it already wrote. Points found
+// in the cache take no time, so a rerun spends the budget on missing points
+void run_full ( const Options &options, ResultCache &cache, ResultSink &sink ) {
+    typedef chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    auto deadline = [&] ( double share ) {
+        return start + chrono::duration_cast<Clock::duration>(
+                chrono::duration<double>(share * options.budget));
+    };
+    uint_fast64_t memory = physical_memory();
+    uint_fast64_t largest = min(options.max, memory / 8);
+    uint_fast64_t page_size = sysconf(_SC_PAGESIZE);
+    Topology topology = Topology::discover();
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            options.min, largest, EXPONENTIALLY_SPACED, options.count);
+    vector<uint_fast64_t> sizes = generator->generate_n(options.count);
+    delete generator;
+    // Key of a point of the sizes of every phase
+    auto key_of = [&] ( const string &kernel, uint_fast64_t size ) {
+        return make_key(kernel, EXPONENTIALLY_SPACED, options.min, largest,
+                options.count, size);
+    };
+    auto write_all = [&] ( const vector<ResultRecord> &records ) {
+        for ( const ResultRecord &record : records ) sink.write(record);
+    };
+    string threads = "_t" + to_string(options.threads);
+
+    // Cache levels, up to 4 times the largest LLC (1 GiB if unknown), so
+    // that the few tens of measurements of the detection stay short
+    uint_fast64_t llc = topology.largest_llc();
+    uint_fast64_t boundary_max = min(largest, llc ? 4ul * llc : 1ul << 30);
+    write_all(cache.fetch(key_of("boundaries", 0), [&] (  ) {
+        PointerChase chase(64ul, 1ul << 18);
+        BoundaryDetector detector(chase);
+        vector<ResultRecord> records;
+        for ( Boundary &boundary : detector.detect(options.min, boundary_max) ) {
+            records.push_back(make_record(EXPONENTIALLY_SPACED, boundary.lower,
+                        "boundary_below_ns", boundary.latency_below, page_size));
+            records.push_back(make_record(EXPONENTIALLY_SPACED, boundary.upper,
+                        "boundary_above_ns", boundary.latency_above, page_size));
+        }
+        return records;
+    }));
+
+    // Latency from every CPU to every node, one measurement at a time per
+    // LLC domain and in parallel across domains. Every domain may hold a
+    // chain at once, so their sizes share the memory of the other phases
+    Clock::time_point limit = deadline(0.3);
+    SweepScheduler scheduler(topology, LLC_DOMAIN);
+    vector<uint_fast64_t> placed_sizes;
+    for ( uint_fast64_t size : sizes )
+        if ( size <= memory / ( 8ul * scheduler.domains() ) )
+            placed_sizes.push_back(size);
+    for ( const Placement &placement : topology.placement_matrix(true) )
+        scheduler.add(placed_sizes, placement,
+                [&] ( const Placement &where, uint_fast64_t size, bool placed ) {
+                    // Results of a placement not applied are not reported
+                    if ( ! placed ) return;
+                    CacheKey key = key_of("latency_placed", size);
+                    key.cpu = where.cpu;
+                    key.node = where.node;
+                    write_all(cache.fetch(key, [&] (  ) {
+                        if ( Clock::now() > limit ) return vector<ResultRecord>();
+                        PointerChase chase;
+                        chase.prepare(size);
+                        ResultRecord record = make_record(EXPONENTIALLY_SPACED,
+                                size, "latency_ns", chase.measure(), page_size);
+                        record.cpu = where.cpu;
+                        record.node = where.node;
+                        return vector<ResultRecord>{ record };
+                    }));
+                });
+    scheduler.run();
+
+    // Bandwidth with every CPU, over the sizes whose arrays fit in the same
+    // share of the memory as the other phases
+    limit = deadline(0.6);
+    BandwidthEngine bandwidth(options.threads, vector<int>(), 1ul << 26);
+    vector<uint_fast64_t> bandwidth_sizes = sizes;
+    fit_bandwidth(bandwidth_sizes, bandwidth.threads(), memory / 8);
+    for ( uint_fast64_t size : bandwidth_sizes )
+        for ( BandwidthKernel kernel : options.kernels )
+            write_all(cache.fetch(key_of("bandwidth_" + kernel_name(kernel) +
+                            threads, size), [&] (  ) {
+                if ( Clock::now() > limit ) return vector<ResultRecord>();
+                return vector<ResultRecord>{ make_record(EXPONENTIALLY_SPACED,
+                        size, "bandwidth_" + kernel_name(kernel) + "_gbps",
+                        bandwidth.measure(kernel, size), page_size,
+                        bandwidth.threads()) };
+            }));
+
+    // Random access throughput
+    limit = deadline(0.75);
+    RandomAccessEngine random(options.threads);
+    for ( uint_fast64_t size : sizes )
+        write_all(cache.fetch(key_of("random" + threads, size), [&] (  ) {
+            vector<ResultRecord> records;
+            if ( Clock::now() > limit ) return records;
+            random.prepare(size);
+            for ( RandomAccessKernel kernel : { RANDOM_READ, RANDOM_UPDATE } )
+                records.push_back(make_record(EXPONENTIALLY_SPACED, size,
+                            random_kernel_name(kernel) + "_mops",
+                            random.measure(kernel), page_size, random.threads()));
+            return records;
+        }));
+
+    // Latency under load, for the largest size
+    limit = deadline(0.9);
+    LoadedLatency loaded(max(options.threads, 2u) - 1u);
+    for ( int node : topology.nodes() ) {
+        CacheKey key = key_of("loaded" + threads, sizes.back());
+        key.node = node;
+        write_all(cache.fetch(key, [&] (  ) {
+            vector<ResultRecord> records;
+            if ( Clock::now() > limit ) return records;
+            for ( LoadedLatencyPoint &point : loaded.measure(node, { sizes.back() }) ) {
+                string step = "_delay" + to_string(point.delay);
+                if ( point.traffic_threads == 0 ) step = "_idle";
+                // The chase thread and the traffic threads loading memory
+                ResultRecord record = make_record(EXPONENTIALLY_SPACED, point.size,
+                        "loaded_latency_ns" + step, point.ns_per_load, page_size,
+                        point.traffic_threads + 1u);
+                record.node = node;
+                records.push_back(record);
+                record.metric = "loaded_bandwidth_gbps" + step;
+                record.value = record.min = record.median = record.p99 = point.gb_per_s;
+                records.push_back(record);
+            }
+            return records;
+        }));
+    }
+
+    // Cache line transfers between every pair of CPUs
+    limit = deadline(1.0);
+    CoreToCore transfers(vector<int>(), 1ul << 14);
+    for ( int from : transfers.cpus() )
+        for ( int to : transfers.cpus() ) {
+            if ( from == to ) continue;
+            string metric = "transfer_to_cpu" + to_string(to) + "_ns";
+            CacheKey key = key_of(metric, 64ul);
+            key.cpu = from;
+            write_all(cache.fetch(key, [&] (  ) {
+                if ( Clock::now() > limit ) return vector<ResultRecord>();
+                ResultRecord record = make_record(EXPONENTIALLY_SPACED, 64ul,
+                        metric, transfers.measure(from, to), page_size);
+                record.cpu = from;
+                return vector<ResultRecord>{ record };
+            }));
+        }
+}
+
+int main ( int argc, char **argv ) {
+    Options options;
+    try {
+        options = parse_options(argc, argv);
+    } catch ( exception &error ) {
+        cerr << error.what() << endl << USAGE;
+        return 2;
+    }
+
+    try {
+        if ( options.command == "sweep" ) {
+            run_sweep(options);
+            return 0;
+        }
+        if ( options.command != "latency" && options.command != "bandwidth" &&
+                options.command != "stride" && options.command != "io" &&
+                options.command != "tlb" && options.command != "full" ) {
+            cerr << "unknown command " << options.command << endl << USAGE;
+            return 2;
+        }
+        ResultSink sink(options.output, options.format);
+        ResultCache cache(options.cache);
+        if ( options.refresh ) cache.invalidate();
+        if ( options.command == "latency" ) run_latency(options, cache, sink);
+        else if ( options.command == "bandwidth" ) run_bandwidth(options, cache, sink);
+        else if ( options.command == "stride" ) run_stride(options, cache, sink);
+        else if ( options.command == "io" ) run_io(options, cache, sink);
+        else if ( options.command == "tlb" ) run_tlb(options, cache, sink);
+        else run_full(options, cache, sink);
+        sink.close();
+        if ( cache.enabled() )
+            cerr << "cache: " << cache.hits() << " points reused, "
+                << cache.misses() << " measured" << endl;
+    } catch ( exception &error ) {
+        cerr << error.what() << endl;
+        return 1;
+    }
+    return 0;
+}
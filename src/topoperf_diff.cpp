@@ -0,0 +1,44 @@
+// Compares two topoperf result files (CSV, JSON Lines or binary) per size
+// Build: g++ -O2 -std=c++11 -pthread src/topoperf_diff.cpp -o topoperf_diff
+// Usage: topoperf_diff <before> <after> [threshold]
+//   Records whose value changed by more than threshold (default 0.05, that
+//   is 5%) are marked with a '*'
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+#include "result_sink.hpp"
+
+int main ( int argc, char **argv ) {
+    if ( argc < 3 ) {
+        cerr << "Usage: " << argv[0] << " <before> <after> [threshold]" << endl;
+        return 2;
+    }
+    double threshold = argc > 3 ? atof(argv[3]) : 0.05;
+    vector<ResultDiff> diffs;
+    try {
+        diffs = diff_results(load_results(argv[1]), load_results(argv[2]));
+    } catch ( exception &error ) {
+        cerr << error.what() << endl;
+        return 1;
+    }
+
+    uint_fast64_t changed = 0;
+    printf("%-16s %-22s %14s %5s %5s %7s %8s %14s %14s %9s\n", "metric",
+            "generator", "size", "cpu", "node", "threads", "page", "before", "after",
+            "change");
+    for ( const ResultDiff &diff : diffs ) {
+        bool mark = fabs(diff.change) > threshold;
+        changed += mark;
+        printf("%-16s %-22s %14lu %5d %5d %7u %8lu %14.4f %14.4f %+8.2f%%%s\n",
+                diff.after.metric.c_str(),
+                generator_name(diff.after.generator).c_str(),
+                (unsigned long) diff.after.size, diff.after.cpu, diff.after.node,
+                diff.after.threads, (unsigned long) diff.after.page_size, diff.before.value,
+                diff.after.value, 100.0 * diff.change, mark ? " *" : "");
+    }
+    printf("%lu of %lu records changed by more than %.2f%%\n",
+            (unsigned long) changed, (unsigned long) diffs.size(), 100.0 * threshold);
+    return 0;
+}
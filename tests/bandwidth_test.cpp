@@ -0,0 +1,106 @@
+#include "simple_tester.hpp"
+
+#include "../src/bandwidth.hpp"
+
+// Checks the results of all kernels of an instruction set over n doubles
+bool kernels_are_correct ( VectorIsa isa, uint_fast64_t n ) {
+    BandwidthKernels kernels = kernels_for(isa);
+    vector<double> a(n + 8), b(n + 8), c(n + 8);
+    // Arrays must be aligned to 64 bytes for the aligned loads and stores
+    double *pa = (double*) (((uintptr_t) a.data() + 63) & ~(uintptr_t) 63);
+    double *pb = (double*) (((uintptr_t) b.data() + 63) & ~(uintptr_t) 63);
+    double *pc = (double*) (((uintptr_t) c.data() + 63) & ~(uintptr_t) 63);
+    for ( uint_fast64_t i = 0; i < n; ++i ) { pb[i] = i; pc[i] = 2.0 * i; }
+
+    bool correct = kernels.read(pb, n) == (double) (n * (n - 1) / 2);
+    kernels.write(pa, 5.0, n);
+    for ( uint_fast64_t i = 0; i < n; ++i ) correct = correct && pa[i] == 5.0;
+    kernels.copy(pa, pb, n);
+    for ( uint_fast64_t i = 0; i < n; ++i ) correct = correct && pa[i] == pb[i];
+    kernels.triad(pa, pb, pc, 3.0, n);
+    for ( uint_fast64_t i = 0; i < n; ++i )
+        correct = correct && pa[i] == 7.0 * i;
+    kernels.rmw(pa, 1.0, n);
+    for ( uint_fast64_t i = 0; i < n; ++i )
+        correct = correct && pa[i] == 7.0 * i + 1.0;
+    kernels.stream_write(pa, 6.0, n);
+    for ( uint_fast64_t i = 0; i < n; ++i ) correct = correct && pa[i] == 6.0;
+    kernels.stream_copy(pa, pc, n);
+    for ( uint_fast64_t i = 0; i < n; ++i ) correct = correct && pa[i] == pc[i];
+    return correct;
+}
+
+void test_BandwidthKernels (  ) {
+    DESCRIBE("Bandwidth Kernels");
+
+    WHEN("I use the scalar kernels over 1024 doubles");
+    IFTHEN("I check every kernel", "they should all be correct");
+    isTrue(kernels_are_correct(SCALAR, 1024));
+
+    WHEN("I use the best kernels supported by this CPU over 1024 doubles");
+    IFTHEN("I check every kernel", "they should all be correct");
+    isTrue(kernels_are_correct(best_vector_isa(), 1024));
+
+    IFTHEN("I check the kernels that were selected", "they should be the best ISA");
+    isTrue(kernels_for(best_vector_isa()).isa == best_vector_isa());
+
+    WHEN("I count the bytes of a triad over 100 doubles");
+    IFTHEN("I check the result", "it should be three arrays of 800 bytes");
+    isEqual(kernel_bytes(TRIAD, 100), (uint_fast64_t) 2400);
+
+    WHEN("I count the bytes of a read-modify-write over 100 doubles");
+    IFTHEN("I check the result", "it should be one array read and written");
+    isEqual(kernel_bytes(RMW, 100), (uint_fast64_t) 1600);
+
+    WHEN("I count the bytes of a non-temporal write over 100 doubles");
+    IFTHEN("I check the result", "it should be one array of 800 bytes");
+    isEqual(kernel_bytes(STREAM_WRITE, 100), (uint_fast64_t) 800);
+}
+
+void test_BandwidthEngine (  ) {
+    DESCRIBE("Bandwidth Engine");
+
+    WHEN("I create an engine with 2 threads");
+    BandwidthEngine engine(2, vector<int>(), 1ul << 22);
+    IFTHEN("I measure a 64 KiB triad", "the bandwidth should be positive");
+    isGreater(engine.measure(TRIAD, 64ul * 1024ul), 0.0);
+
+    WHEN("I sweep an Exponential Distribution from 4 KiB to 1 MiB with 4 points");
+    IFTHEN("I measure read and copy", "I should get 8 results");
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            4096, 1024*1024, EXPONENTIALLY_SPACED, 4);
+    vector<BandwidthPoint> points = engine.sweep(generator, {READ, COPY});
+    isEqual(points.size(), (size_t) 8);
+    IFTHEN("I check the results", "they should all have positive bandwidth and 2 threads");
+    bool valid = true;
+    for ( BandwidthPoint &point : points )
+        valid = valid && point.gb_per_s > 0.0 && point.threads == 2u;
+    isTrue(valid);
+
+    WHEN("I measure a 64 KiB non-temporal copy");
+    IFTHEN("I check the bandwidth", "it should be positive");
+    isGreater(engine.measure(STREAM_COPY, 64ul * 1024ul), 0.0);
+
+    WHEN("I measure flushing 64 KiB of dirty lines with clflush");
+    IFTHEN("I check the time per line", "it should be positive");
+    isGreater(engine.measure_flush(CLFLUSH, 64ul * 1024ul), 0.0);
+
+    WHEN("I sweep flushes over a Uniform Distribution from 4 KiB to 64 KiB with 2 points");
+    IFTHEN("I check the results", "there should be one per supported instruction and size");
+    generator = DistributionGenerator::make_generator(4096, 64*1024,
+            UNIFORMLY_SPACED, 2);
+    vector<FlushPoint> flushes = engine.flush_sweep(generator);
+    uint_fast64_t supported = 0;
+    for ( FlushInstruction instruction : { CLFLUSH, CLFLUSHOPT, CLWB } )
+        supported += flush_supported(instruction) ? 1 : 0;
+    isEqual(flushes.size(), (size_t) ( 2 * supported ));
+    valid = true;
+    for ( FlushPoint &point : flushes ) valid = valid && point.ns_per_line > 0.0;
+    IFTHEN("I check the times", "they should all be positive");
+    isTrue(valid);
+}
+
+int main () {
+    test_BandwidthKernels();
+    test_BandwidthEngine();
+}
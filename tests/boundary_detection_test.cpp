@@ -0,0 +1,75 @@
+#include "simple_tester.hpp"
+
+#include "../src/boundary_detection.hpp"
+
+// Latency of a fake machine with a 32 KiB L1, a 1 MiB L2 and memory
+double fake_latency ( uint_fast64_t size ) {
+    if ( size <= 32ul * 1024ul ) return 1.0;
+    else if ( size <= 1024ul * 1024ul ) return 4.0;
+    else return 80.0;
+}
+
+// Latency of a fake machine whose 2 MiB L3 fills on the coarse point after
+// the 1 MiB L2 boundary
+double adjacent_latency ( uint_fast64_t size ) {
+    if ( size <= 1024ul * 1024ul ) return 4.0;
+    else if ( size <= 2048ul * 1024ul ) return 20.0;
+    else return 80.0;
+}
+
+// Latency of a fake machine whose only level fills gradually from 1 MiB
+// to 16 MiB
+double ramp_latency ( uint_fast64_t size ) {
+    double ratio = (double) size / ( 1024ul * 1024ul );
+    return ratio <= 1.0 ? 4.0 : 4.0 * pow(min(ratio, 16.0), 1.5);
+}
+
+void test_BoundaryDetector (  ) {
+    DESCRIBE("Boundary Detector");
+
+    WHEN("I detect boundaries of a fake machine from 1 KiB to 1 GiB");
+    BoundaryDetector detector(fake_latency, 0.05);
+    vector<Boundary> boundaries = detector.detect(1024ul, 1ul << 30);
+    IFTHEN("I count the boundaries", "there should be 2");
+    isEqual(boundaries.size(), (size_t) 2);
+    IFTHEN("I check the first boundary", "it should bracket 32 KiB within 5%");
+    isTrue(boundaries[0].lower <= 32ul * 1024ul && boundaries[0].upper > 32ul * 1024ul &&
+            (double) boundaries[0].upper / boundaries[0].lower <= 1.05);
+    IFTHEN("I check the second boundary", "it should bracket 1 MiB within 5%");
+    isTrue(boundaries[1].lower <= 1024ul * 1024ul && boundaries[1].upper > 1024ul * 1024ul &&
+            (double) boundaries[1].upper / boundaries[1].lower <= 1.05);
+    IFTHEN("I check the latencies around the second boundary", "they should be 4 and 80");
+    isTrue(boundaries[1].latency_below == 4.0 && boundaries[1].latency_above == 80.0);
+    IFTHEN("I count the measurements", "there should be fewer than 100");
+    isLess(detector.measurements(), (uint_fast64_t) 100);
+
+    WHEN("I detect boundaries of levels that jump on adjacent coarse points");
+    vector<Boundary> adjacent = BoundaryDetector(adjacent_latency).detect(1024ul, 1ul << 30);
+    IFTHEN("I count the boundaries", "there should be 2, one for each level");
+    isEqual(adjacent.size(), (size_t) 2);
+    IFTHEN("I check the second boundary", "it should bracket 2 MiB");
+    isTrue(adjacent.size() == 2 && adjacent[1].lower <= 2048ul * 1024ul &&
+            adjacent[1].upper > 2048ul * 1024ul);
+
+    WHEN("I detect boundaries of a level that fills over several coarse points");
+    IFTHEN("I count the boundaries", "there should be 1");
+    isEqual(BoundaryDetector(ramp_latency).detect(1024ul, 1ul << 30).size(), (size_t) 1);
+
+    WHEN("I detect boundaries of a flat latency curve");
+    BoundaryDetector flat([] ( uint_fast64_t ) { return 1.0; });
+    IFTHEN("I count the boundaries", "there should be none");
+    isEqual(flat.detect(1024ul, 1ul << 20).size(), (size_t) 0);
+
+    WHEN("I detect boundaries with a pointer chase from 4 KiB to 64 KiB");
+    PointerChase chase(64ul, 1ul << 12);
+    BoundaryDetector measured(chase);
+    measured.detect(4096ul, 64ul * 1024ul, 4);
+    IFTHEN("I check the measurements", "all latencies should be positive");
+    bool positive = measured.measurements() > 0;
+    for ( auto &latency : measured.latencies() ) positive = positive && latency.second > 0.0;
+    isTrue(positive);
+}
+
+int main () {
+    test_BoundaryDetector();
+}
@@ -0,0 +1,71 @@
+#include "simple_tester.hpp"
+
+#include "../src/buffer_arena.hpp"
+#include "../src/bandwidth.hpp"
+#include "../src/pointer_chase.hpp"
+
+void test_BufferArena (  ) {
+    DESCRIBE("Buffer Arena");
+
+    WHEN("I create an arena of 1 MiB with small pages");
+    BufferArena small(1024ul * 1024ul, SMALL_PAGES);
+    IFTHEN("I check its pages", "they should be base pages");
+    isTrue(small.page_kind() == SMALL_PAGES && small.page_size() == (uint_fast64_t) sysconf(_SC_PAGESIZE));
+    IFTHEN("I check its size", "it should be 1 MiB");
+    isEqual(small.size(), (uint_fast64_t) 1024ul * 1024ul);
+
+    WHEN("I create an arena of 3 MiB with 2 MiB pages");
+    BufferArena huge(3ul * 1024ul * 1024ul, HUGE_2M);
+    IFTHEN("I check its pages", "they should be 2 MiB pages or transparent huge pages");
+    isTrue(huge.page_size() == (uint_fast64_t) 2 * 1024 * 1024 || huge.page_kind() == SMALL_PAGES);
+    IFTHEN("I check its size", "it should be rounded up to whole pages");
+    isEqual(huge.size() % huge.page_size(), (uint_fast64_t) 0);
+    IFTHEN("I write to all of it", "it should be usable");
+    char *bytes = huge.view<char>(huge.size());
+    for ( uint_fast64_t i = 0; i < huge.size(); i += 64 ) bytes[i] = 1;
+    isEqual(bytes[huge.size() - 64], (char) 1);
+
+    WHEN("I ask for a view larger than the arena");
+    IFTHEN("I check the result", "it should throw out_of_range");
+    bool thrown = false;
+    try { small.view<char>(1024ul, small.size()); } catch ( out_of_range & ) { thrown = true; }
+    isTrue(thrown);
+
+    WHEN("I create an arena for an Exponential Distribution up to 256 KiB");
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            4096, 256*1024, EXPONENTIALLY_SPACED, 4);
+    BufferArena sized(*generator, TRANSPARENT_HUGE);
+    IFTHEN("I check its size", "it should hold the largest size");
+    isGreaterOrEqual(sized.size(), (uint_fast64_t) 256ul * 1024ul);
+
+    IFTHEN("I check its pages", "they should be huge pages only if the kernel promoted them");
+    string enabled;
+    getline(ifstream("/sys/kernel/mm/transparent_hugepage/enabled"), enabled);
+    isTrue(sized.page_kind() == TRANSPARENT_HUGE ? sized.page_size() == 2ul << 20 &&
+            enabled.find("[never]") == string::npos :
+            sized.page_size() == (uint_fast64_t) sysconf(_SC_PAGESIZE));
+
+    IFTHEN("I sweep a pointer chase in it", "results should report its page size");
+    PointerChase chase(64ul, 1ul << 12);
+    chase.attach(sized);
+    vector<LatencyPoint> points = chase.sweep(generator);
+    bool reported = points.size() == 4;
+    for ( LatencyPoint &point : points )
+        reported = reported && point.page_size == sized.page_size() && point.ns_per_load > 0.0;
+    isTrue(reported);
+
+    IFTHEN("I prepare a chain larger than the arena", "it should throw length_error");
+    thrown = false;
+    try { chase.prepare(sized.size() * 2); } catch ( length_error & ) { thrown = true; }
+    isTrue(thrown);
+
+    WHEN("I split an arena between the arrays of a bandwidth engine");
+    BandwidthEngine engine(2, vector<int>(), 1ul << 20);
+    engine.attach(huge);
+    IFTHEN("I measure a triad of 64 KiB", "the bandwidth should be positive");
+    isGreater(engine.measure(TRIAD, 64ul * 1024ul), 0.0);
+}
+
+int main () {
+    test_BufferArena();
+}
@@ -0,0 +1,47 @@
+#include "simple_tester.hpp"
+
+#include "../src/core_to_core.hpp"
+
+void test_CoreToCore (  ) {
+    DESCRIBE("Core to Core Transfers");
+
+    // CPUs may be shared by both threads, so few round trips are used
+    int first = allowed_cpus().front();
+    int last = allowed_cpus().back();
+    CoreToCore transfers(vector<int>(), 256);
+
+    WHEN("I bounce a cache line between the first and last allowed CPUs");
+    IFTHEN("I use atomic ping-pong", "the latency should be positive");
+    isGreater(transfers.measure(first, last, PING_PONG), 0.0);
+    IFTHEN("I use stores to a shared line", "the latency should be positive");
+    isGreater(transfers.measure(first, last, SHARED_TO_MODIFIED), 0.0);
+
+    WHEN("I build the matrix of 2 CPUs");
+    CoreToCore pair( { first, last }, 256);
+    vector<TransferPoint> matrix = pair.matrix();
+    IFTHEN("I count the results", "there should be 4 points");
+    isEqual(matrix.size(), (size_t) 4);
+    IFTHEN("I check the order", "it should be by row");
+    isTrue(matrix[1].from == first && matrix[1].to == last &&
+            matrix[2].from == last && matrix[2].to == first);
+    IFTHEN("I check the diagonal", "it should not be measured");
+    isTrue(matrix[0].ns_per_transfer == 0.0 && matrix[3].ns_per_transfer == 0.0);
+
+    WHEN("I sweep an Exponential Distribution of payloads from 64 B to 4 KiB with 3 points");
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            64, 4096, EXPONENTIALLY_SPACED, 3);
+    vector<TransferPoint> points = transfers.sweep(first, last, generator);
+    delete generator;
+    IFTHEN("I check the results", "there should be 3 increasing payloads with positive latency");
+    isEqual(points.size(), (size_t) 3);
+    bool valid = true;
+    for ( uint_fast64_t i = 0; i < points.size(); ++i )
+        valid = valid && points[i].ns_per_transfer > 0.0 &&
+            points[i].kind == SHARED_TO_MODIFIED &&
+            ( i == 0 || points[i].payload > points[i - 1].payload );
+    isTrue(valid);
+}
+
+int main () {
+    test_CoreToCore();
+}
@@ -184,6 +184,177 @@ DistributionGenerator *generator;
 
 }
 
+void test_Seeding (  ) {
+    DistributionGenerator *first;
+    DistributionGenerator *second;
+
+    DESCRIBE("Seeded Random Distributions");
+
+    WHEN("I create two Random Uniform Distributions with the same seed");
+    IFTHEN("I generate all points", "they should be the same");
+    first = DistributionGenerator::make_generator(10, 1000000, UNIFORMLY_RANDOM, 1000, 7);
+    second = DistributionGenerator::make_generator(10, 1000000, UNIFORMLY_RANDOM, 1000, 7);
+    isTrue(first->generate_n(1000) == second->generate_n(1000));
+
+    WHEN("I create two Random Exponential Distributions with the same seed");
+    IFTHEN("I generate all points", "they should be the same");
+    first = DistributionGenerator::make_generator(10, 1000000, EXPONENTIALLY_RANDOM, 1000, 7);
+    second = DistributionGenerator::make_generator(10, 1000000, EXPONENTIALLY_RANDOM, 1000, 7);
+    isTrue(first->generate_n(1000) == second->generate_n(1000));
+
+    WHEN("I create two Random Uniform Distributions with different seeds");
+    IFTHEN("I generate all points", "they should differ");
+    first = DistributionGenerator::make_generator(10, 1000000, UNIFORMLY_RANDOM, 1000, 7);
+    second = DistributionGenerator::make_generator(10, 1000000, UNIFORMLY_RANDOM, 1000, 8);
+    isTrue(first->generate_n(1000) != second->generate_n(1000));
+
+    WHEN("I create two Random Distributions with the same seed of each kind");
+    IFTHEN("I fill the points of one and call next on the other", "they should be the same");
+    bool same = true;
+    for ( Generators kind : { UNIFORMLY_RANDOM, EXPONENTIALLY_RANDOM } ) {
+        first = DistributionGenerator::make_generator(10, 1000000, kind, 1000, 7);
+        second = DistributionGenerator::make_generator(10, 1000000, kind, 1000, 7);
+        for ( uint_fast64_t point : first->generate_n(1000) )
+            same = same && point == second->next();
+    }
+    isTrue(same);
+
+    WHEN("I create a Random Uniform Distribution from 10 to 1000 on the random device");
+    IFTHEN("I generate all points", "they should all be between 10 and 1000");
+    UniformlyRandom<DeviceEngine> device(10, 1000, 100);
+    bool inside_interval = true;
+    for ( uint_fast64_t point : device.generate_n(100) )
+        inside_interval = inside_interval && ( point >= 10ul ) && ( point <= 1000ul );
+    isTrue(inside_interval);
+}
+
+// Checks that fill provides the same points as a loop over next
+bool fill_matches_next ( Generators kind, uint_fast64_t min, uint_fast64_t max,
+        uint_fast64_t count ) {
+    DistributionGenerator *looped = DistributionGenerator::make_generator(min, max, kind, count);
+    DistributionGenerator *filled = DistributionGenerator::make_generator(min, max, kind, count);
+    vector<uint_fast64_t> points(count + 10);
+    uint_fast64_t written = filled->fill(points.data(), 3);
+    written += filled->fill(points.data() + written, points.size() - written);
+    bool same = filled->is_done();
+    uint_fast64_t i = 0;
+    while ( ! looped->is_done() ) same = same && (i < written) && points[i++] == looped->next();
+    return same && i == written;
+}
+
+void test_BulkGeneration (  ) {
+    DistributionGenerator *generator;
+
+    DESCRIBE("Bulk Generation");
+
+    WHEN("I fill points from deterministic generators in two steps");
+    IFTHEN("I compare them to calls to next", "they should be the same for an Average Point");
+    isTrue(fill_matches_next(AVERAGE_POINT, 2, 12, 1));
+    IFTHEN("I compare them to calls to next", "they should be the same for a Uniform Distribution");
+    isTrue(fill_matches_next(UNIFORMLY_SPACED, 0, 1024*1024, 1000));
+    IFTHEN("I compare them to calls to next", "they should be the same for an Exponential Distribution");
+    isTrue(fill_matches_next(EXPONENTIALLY_SPACED, 1, 1ul << 40, 1000));
+    IFTHEN("I compare them to calls to next", "they should be the same for a Mid Point");
+    isTrue(fill_matches_next(MID_POINT, 2, 32, 1));
+
+    WHEN("I generate 200 points from a Random Uniform Distribution with 100 points");
+    IFTHEN("I check the result", "it should have 100 points");
+    generator = DistributionGenerator::make_generator(10, 1000, UNIFORMLY_RANDOM, 100);
+    vector<uint_fast64_t> points = generator->generate_n(200);
+    isEqual(points.size(), (size_t) 100);
+    IFTHEN("I check if it is done", "it should be done");
+    isTrue(generator->is_done());
+
+    WHEN("I generate 100 points from a Random Exponential Distribution from 10 to 1000");
+    IFTHEN("I check all points", "they should all be between 10 and 1000");
+    generator = DistributionGenerator::make_generator(10, 1000, EXPONENTIALLY_RANDOM, 100);
+    points = generator->generate_n(100);
+    bool inside_interval = points.size() == 100;
+    for ( uint_fast64_t point : points )
+        inside_interval = inside_interval && ( point >= 10ul ) && ( point <= 1000ul );
+    isTrue(inside_interval);
+}
+
+void test_LargeRanges (  ) {
+    DistributionGenerator *generator;
+
+    DESCRIBE("Large Ranges");
+
+    WHEN("I create an Average Point from 2^64 - 11 to 2^64 - 1");
+    IFTHEN("I generate a point", "the result should be 2^64 - 6 (no overflow)");
+    generator = DistributionGenerator::make_generator(UINT_FAST64_MAX - 10, UINT_FAST64_MAX);
+    isEqual(generator->next(), UINT_FAST64_MAX - 5);
+
+    WHEN("I create a Uniform Distribution from 0 to 3 * 2^62 with 2 points");
+    IFTHEN("I generate all points", "they should be 2^62 and 2^63 (no overflow)");
+    generator = DistributionGenerator::make_generator(0, 3ul << 62, UNIFORMLY_SPACED, 2);
+    isEqual(generator->next(), 1ul << 62);
+    isEqual(generator->next(), 1ul << 63);
+
+    WHEN("I create an Exponential Distribution from 2^60 + 1 to 2^62 + 4 with 1 point");
+    IFTHEN("I generate a point", "it should be exactly 2^61 + 2 (too large for a double)");
+    generator = DistributionGenerator::make_generator((1ul << 60) + 1, (1ul << 62) + 4,
+            EXPONENTIALLY_SPACED, 1);
+    isEqual(generator->next(), (1ul << 61) + 2);
+
+    WHEN("I create a Mid Point from 2^60 + 1 to 2^62 + 4");
+    IFTHEN("I generate a point", "it should be exactly 2^61 + 2 (too large for a double)");
+    generator = DistributionGenerator::make_generator((1ul << 60) + 1, (1ul << 62) + 4,
+            MID_POINT);
+    isEqual(generator->next(), (1ul << 61) + 2);
+
+    WHEN("I create an Exponential Distribution from 2^32 to 2^64 - 1 with 100 points");
+    IFTHEN("I check all points", "they should be increasing and inside the limits");
+    generator = DistributionGenerator::make_generator(1ul << 32, UINT_FAST64_MAX,
+            EXPONENTIALLY_SPACED, 100);
+    vector<uint_fast64_t> points = generator->generate_n(100);
+    bool increasing = points.size() == 100 && points.front() > ( 1ul << 32 );
+    for ( uint_fast64_t i = 1; i < points.size(); ++i )
+        increasing = increasing && points[i - 1] < points[i];
+    isTrue(increasing);
+
+    WHEN("I fill points over the whole 64-bit range in two steps");
+    IFTHEN("I compare them to calls to next", "they should be the same for a Uniform Distribution");
+    isTrue(fill_matches_next(UNIFORMLY_SPACED, 0, UINT_FAST64_MAX, 1000));
+    IFTHEN("I compare them to calls to next", "they should be the same for an Exponential Distribution");
+    isTrue(fill_matches_next(EXPONENTIALLY_SPACED, 1, UINT_FAST64_MAX, 1000));
+}
+
+void test_Alignment (  ) {
+    DistributionGenerator *generator;
+
+    DESCRIBE("Aligned Distributions");
+
+    WHEN("I create an Average Point from 1000 to 3000 aligned to 1024");
+    IFTHEN("I generate a point", "the result should be 2048, the nearest multiple of 2000");
+    generator = DistributionGenerator::make_generator(1000, 3000, AVERAGE_POINT, 1, 0, 1024);
+    isEqual(generator->next(), (uint_fast64_t) 2048);
+
+    WHEN("I create a Uniform Distribution from 5000 to 9000 with 1 point aligned to 4096");
+    IFTHEN("I generate a point", "the result should be 8192, the only multiple inside the limits");
+    generator = DistributionGenerator::make_generator(5000, 9000, UNIFORMLY_SPACED, 1, 0, 4096);
+    isEqual(generator->next(), (uint_fast64_t) 8192);
+
+    WHEN("I create an Average Point from 5000 to 6000 aligned to 4096");
+    IFTHEN("I generate a point", "the result should not be aligned, as no multiple is inside the limits");
+    generator = DistributionGenerator::make_generator(5000, 6000, AVERAGE_POINT, 1, 0, 4096);
+    isEqual(generator->next(), (uint_fast64_t) 5500);
+
+    WHEN("I generate 50 points of every kind from 4 KiB to 1 GiB aligned to 4096");
+    IFTHEN("I check all points", "they should be multiples of 4096 inside the limits");
+    bool aligned = true;
+    for ( int kind = AVERAGE_POINT; kind <= EXPONENTIALLY_RANDOM; ++kind ) {
+        generator = DistributionGenerator::make_generator(4096, 1ul << 30,
+                (Generators) kind, 50, 7, 4096);
+        aligned = aligned && generator->alignment() == 4096ul;
+        for ( uint_fast64_t point : generator->generate_n(50) )
+            aligned = aligned && point % 4096 == 0 && point >= 4096ul &&
+                point <= ( 1ul << 30 );
+        delete generator;
+    }
+    isTrue(aligned);
+}
+
 int main () {
     test_AveragePoint();
     test_UniformlySpaced();
@@ -191,4 +362,8 @@ int main () {
     test_MidPoint();
     test_UniformlyRandom();
     test_ExponentiallyRandom();
+    test_BulkGeneration();
+    test_Seeding();
+    test_LargeRanges();
+    test_Alignment();
 }
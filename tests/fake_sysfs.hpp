@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+// Writes a file of a fake sysfs tree, creating its directory
+void write_file ( const string &directory, const string &name, const string &content ) {
+    system(("mkdir -p " + directory).c_str());
+    ofstream file(directory + "/" + name);
+    file << content << "\n";
+}
+
+// Creates under root a fake machine with 2 packages of 2 CPUs, one NUMA node
+// per package and one L3 of 32 MiB per package. Returns root
+string fake_sysfs ( const string &root ) {
+    system(("rm -rf " + root).c_str());
+    write_file(root + "/cpu", "online", "0-3");
+    write_file(root + "/node", "online", "0-1");
+    write_file(root + "/node/node0", "cpulist", "0-1");
+    write_file(root + "/node/node1", "cpulist", "2-3");
+    for ( int cpu = 0; cpu < 4; ++cpu ) {
+        string base = root + "/cpu/cpu" + to_string(cpu);
+        write_file(base + "/topology", "core_id", to_string(cpu % 2));
+        write_file(base + "/topology", "physical_package_id", to_string(cpu / 2));
+        write_file(base + "/cache/index0", "level", "1");
+        write_file(base + "/cache/index0", "type", "Data");
+        write_file(base + "/cache/index0", "shared_cpu_list", to_string(cpu));
+        write_file(base + "/cache/index1", "level", "3");
+        write_file(base + "/cache/index1", "type", "Unified");
+        write_file(base + "/cache/index1", "shared_cpu_list", cpu < 2 ? "0-1" : "2-3");
+        write_file(base + "/cache/index1", "size", "32768K");
+    }
+    return root;
+}
@@ -0,0 +1,71 @@
+#include "simple_tester.hpp"
+
+#include "../src/file_io.hpp"
+
+void test_FileIo (  ) {
+    DESCRIBE("File I/O");
+
+    WHEN("I read 1 MiB of a file with warm page cache");
+    FileIo io("", 1ul << 24);
+    FileIoPoint warm = io.measure(MMAP_READ, WARM_CACHE, 1ul << 20);
+    IFTHEN("I check the bandwidth", "it should be positive");
+    isGreater(warm.gb_per_s, 0.0);
+    IFTHEN("I check the resident pages", "they should all be in the page cache");
+    isEqual(warm.resident, 1.0);
+
+    WHEN("I read 1 MiB of the file with cold page cache");
+    FileIoPoint cold = io.measure(READ_CALL, COLD_CACHE, 1ul << 20);
+    IFTHEN("I check the bandwidth", "it should be positive");
+    isGreater(cold.gb_per_s, 0.0);
+    IFTHEN("I check the resident pages", "they should be a fraction");
+    isTrue(cold.resident >= 0.0 && cold.resident <= 1.0);
+
+    WHEN("I read 5000 bytes with pread");
+    IFTHEN("I check the size", "it should be rounded up to 2 pages");
+    isEqual(io.measure(PREAD_CALL, WARM_CACHE, 5000).size, (uint_fast64_t) 8192);
+
+    WHEN("I sweep an Exponential Distribution from 64 KiB to 1 MiB with 2 points");
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            64*1024, 1024*1024, EXPONENTIALLY_SPACED, 2);
+    vector<FileIoPoint> points = io.sweep(generator, { MMAP_SEQUENTIAL, PREAD_CALL });
+    delete generator;
+    IFTHEN("I count the points", "there should be one per size, state and access");
+    isEqual(points.size(), (size_t) 8);
+    bool positive = true;
+    for ( FileIoPoint &point : points ) positive = positive && point.gb_per_s > 0.0;
+    IFTHEN("I check the bandwidths", "they should all be positive");
+    isTrue(positive);
+
+    WHEN("I measure the page faults of 4 MiB of small pages");
+    PageFaultPoint faults = io.measure_faults(SMALL_PAGES, 4ul << 20);
+    IFTHEN("I check the page size", "it should be the base page size");
+    isEqual(faults.page_size, (uint_fast64_t) sysconf(_SC_PAGESIZE));
+    IFTHEN("I check the time per fault", "it should be positive");
+    isGreater(faults.ns_per_fault, 0.0);
+
+    WHEN("I measure the page faults of 4 MiB of the file in small and huge pages");
+    PageFaultPoint small = io.measure_faults(SMALL_PAGES, 4ul << 20, MAPPED_FILE);
+    PageFaultPoint huge = io.measure_faults(TRANSPARENT_HUGE, 4ul << 20, MAPPED_FILE);
+    IFTHEN("I check the small pages", "they should be base pages of the file");
+    isTrue(small.target == MAPPED_FILE && small.kind == SMALL_PAGES &&
+            small.page_size == (uint_fast64_t) sysconf(_SC_PAGESIZE));
+    // Huge pages of a file depend on its file system, so any kind is accepted
+    IFTHEN("I check the huge pages", "their size should match the kind obtained");
+    isTrue(huge.target == MAPPED_FILE &&
+            huge.page_size == ( huge.kind == SMALL_PAGES ?
+                (uint_fast64_t) sysconf(_SC_PAGESIZE) : 1ul << 21 ));
+    IFTHEN("I check the times per fault", "they should be positive");
+    isTrue(small.ns_per_fault > 0.0 && huge.ns_per_fault > 0.0);
+
+    WHEN("I sweep the faults of 2 sizes with every kind of page");
+    generator = DistributionGenerator::make_generator(
+            64*1024, 1024*1024, EXPONENTIALLY_SPACED, 2);
+    vector<PageFaultPoint> fault_points = io.fault_sweep(generator);
+    delete generator;
+    IFTHEN("I count the points", "the file should skip hugetlbfs pages");
+    isEqual(fault_points.size(), (size_t) 10);
+}
+
+int main () {
+    test_FileIo();
+}
@@ -0,0 +1,52 @@
+#include "simple_tester.hpp"
+
+#include "../src/loaded_latency.hpp"
+
+void test_LoadedLatency (  ) {
+    DESCRIBE("Loaded Latency");
+
+    Topology topology = Topology::discover();
+    int node = topology.nodes().front();
+
+    WHEN("I measure 2 sizes with 2 intensity steps and 2 traffic threads");
+    LoadedLatency loaded(2, COPY, {0ul, 4096ul}, 1ul << 20, 1ul << 14, topology);
+    vector<LoadedLatencyPoint> points = loaded.measure(node, {4096ul, 1ul << 20});
+    IFTHEN("I count the results", "there should be an idle point and 2 loaded points per size");
+    isEqual(points.size(), (size_t) 6);
+    IFTHEN("I check the idle points", "they should have no traffic");
+    isTrue(points[0].traffic_threads == 0u && points[0].gb_per_s == 0.0 &&
+            points[3].traffic_threads == 0u && points[3].size == 1ul << 20);
+    // Traffic threads may not run during a short chase when they share its CPU
+    IFTHEN("I check the loaded points", "they should have positive latency and 2 traffic threads");
+    bool valid = true;
+    for ( LoadedLatencyPoint &point : points )
+        valid = valid && point.node == node && point.ns_per_load > 0.0 &&
+            point.gb_per_s >= 0.0 &&
+            ( point.traffic_threads == 0u || point.traffic_threads == 2u );
+    isTrue(valid);
+    IFTHEN("I check the delays", "they should follow the intensity steps");
+    isTrue(points[1].delay == 0ul && points[2].delay == 4096ul);
+
+    WHEN("I sweep an Exponential Distribution from 4 KiB to 64 KiB with 2 points");
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            4096, 64*1024, EXPONENTIALLY_SPACED, 2);
+    LoadedLatency single(1, READ, {0ul}, 1ul << 20, 1ul << 14, topology);
+    points = single.sweep(generator);
+    delete generator;
+    IFTHEN("I count the results", "there should be 4 points for every node");
+    isEqual(points.size(), 4 * topology.nodes().size());
+
+    WHEN("I load the chase with the RMW and streaming kernels");
+    bool measured = true;
+    for ( BandwidthKernel kernel : { RMW, STREAM_WRITE, STREAM_COPY } ) {
+        LoadedLatency streaming(1, kernel, {0ul}, 1ul << 20, 1ul << 14, topology);
+        for ( LoadedLatencyPoint &point : streaming.measure(node, {4096ul}) )
+            measured = measured && point.ns_per_load > 0.0 && point.gb_per_s >= 0.0;
+    }
+    IFTHEN("I check the points", "they should have positive latency");
+    isTrue(measured);
+}
+
+int main () {
+    test_LoadedLatency();
+}
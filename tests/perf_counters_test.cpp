@@ -0,0 +1,88 @@
+#include "simple_tester.hpp"
+
+#include "../src/perf_counters.hpp"
+#include "../src/pointer_chase.hpp"
+#include "../src/result_sink.hpp"
+#include "../src/stride_access.hpp"
+#include "../src/timing.hpp"
+#include "../src/tlb_reach.hpp"
+
+void test_CounterValues (  ) {
+    DESCRIBE("Counter Values");
+
+    WHEN("I create empty counter values");
+    CounterValues values;
+    IFTHEN("I check the available events", "there should be none");
+    isTrue(! values.any());
+
+    WHEN("I divide 1000 instructions by 100 operations");
+    values.values[INSTRUCTIONS] = 1000.0;
+    values.available[INSTRUCTIONS] = true;
+    IFTHEN("I check the result", "it should be 10 instructions per operation");
+    isTrue(values.any() && values.per(100.0)[INSTRUCTIONS] == 10.0);
+
+    WHEN("I turn statistics with one counter into records");
+    TimingStats stats;
+    stats.counters = values;
+    ResultRecord record;
+    record.size = 4096;
+    record.metric = "latency_ns";
+    vector<ResultRecord> records = counter_records(record, stats);
+    IFTHEN("I check the records", "there should be one instructions record of the same size");
+    isTrue(records.size() == 1 && records[0].metric == "instructions" &&
+            records[0].size == 4096 && records[0].value == 1000.0);
+}
+
+void test_PerfCounters (  ) {
+    DESCRIBE("Performance Counters");
+
+    WHEN("I count all events around a 1 MiB pointer chase");
+    PerfCounters counters;
+    PointerChase chase(64, 1ul << 16);
+    chase.prepare(1ul << 20);
+    counters.start();
+    chase.traverse();
+    CounterValues values = counters.stop();
+    // Machines without a PMU (or perf_event_open) must give no values
+    IFTHEN("I check the available events", "they should match the group");
+    bool consistent = values.any() == counters.available();
+    for ( unsigned event = 0; event < COUNTER_EVENTS; ++event )
+        consistent = consistent && ( ! values.available[event] ||
+                counters.available((CounterEvent) event) );
+    isTrue(consistent);
+    IFTHEN("I check the instructions", "there should be at least one per load if counted");
+    isTrue(! values.available[INSTRUCTIONS] ||
+            values[INSTRUCTIONS] >= chase.loads());
+
+    WHEN("I attach the counters to a harness");
+    MeasurementHarness harness(1, 3, 3);
+    harness.attach(counters);
+    TimingStats stats = harness.run([&] (  ) { chase.traverse(); }, chase.loads());
+    IFTHEN("I check the time and the counters", "time should be positive and counters per load");
+    isTrue(stats.mean > 0.0 && stats.counters.any() == counters.available() &&
+            ( ! stats.counters.available[INSTRUCTIONS] ||
+              stats.counters[INSTRUCTIONS] >= 1.0 ));
+
+    WHEN("I attach the counters to stride and TLB measurements");
+    StrideAccess access(1ul << 20, 1ul << 16);
+    access.attach(counters);
+    StridePoint stride = access.measure(64, SHUFFLED);
+    TlbReach reach(SMALL_PAGES, 1ul << 16);
+    reach.attach(counters);
+    TlbPoint tlb = reach.measure(64);
+    IFTHEN("I check their counters", "they should be per load if counted");
+    isTrue(stride.counters.any() == counters.available() &&
+            tlb.counters.any() == counters.available() &&
+            ( ! tlb.counters.available[INSTRUCTIONS] ||
+              tlb.counters[INSTRUCTIONS] >= 1.0 ));
+    IFTHEN("I turn the TLB counters into records", "their metrics should have the prefix");
+    bool prefixed = true;
+    for ( ResultRecord &counter : counter_records(ResultRecord(), tlb.counters, "tlb_") )
+        prefixed = prefixed && counter.metric.compare(0, 4, "tlb_") == 0;
+    isTrue(prefixed);
+}
+
+int main () {
+    test_CounterValues();
+    test_PerfCounters();
+}
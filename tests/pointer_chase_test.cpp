@@ -0,0 +1,52 @@
+#include "simple_tester.hpp"
+
+#include "../src/pointer_chase.hpp"
+
+void test_PointerChase (  ) {
+    PointerChase chase(64ul, 1ul << 12);
+
+    DESCRIBE("Pointer Chase");
+
+    WHEN("I prepare a chain over 64 KiB with 64 B slots");
+    IFTHEN("I follow the chain", "it should visit all 1024 slots before repeating");
+    chase.prepare(64ul * 1024ul);
+    isEqual(chase.chain_length(), (uint_fast64_t) 1024);
+
+    IFTHEN("I measure it", "the latency should be positive");
+    isGreater(chase.measure(), 0.0);
+
+    WHEN("I prepare a chain smaller than a slot");
+    IFTHEN("I follow the chain", "it should have a single slot");
+    chase.prepare(10ul);
+    isEqual(chase.chain_length(), (uint_fast64_t) 1);
+
+    WHEN("I prepare a chain again over 64 KiB");
+    IFTHEN("I follow the chain", "it should still be a single cycle");
+    chase.prepare(64ul * 1024ul);
+    isEqual(chase.chain_length(), (uint_fast64_t) 1024);
+
+    WHEN("I prepare a chain of more than 2^32 slots");
+    IFTHEN("I check the result", "it should throw length_error");
+    bool thrown = false;
+    try { chase.prepare(( ( 1ul << 32 ) + 1ul ) * 64ul); } catch ( length_error & ) { thrown = true; }
+    isTrue(thrown);
+
+    WHEN("I sweep an Exponential Distribution from 4 KiB to 1 MiB with 8 points");
+    IFTHEN("I measure all sizes", "I should get 8 results");
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            4096, 1024*1024, EXPONENTIALLY_SPACED, 8);
+    vector<LatencyPoint> points = chase.sweep(generator);
+    isEqual(points.size(), (size_t) 8);
+    IFTHEN("I check the results", "they should keep the generated sizes and positive latencies");
+    bool valid = true;
+    uint_fast64_t previous = 0ul;
+    for ( LatencyPoint &point : points ) {
+        valid = valid && point.size > previous && point.ns_per_load > 0.0;
+        previous = point.size;
+    }
+    isTrue(valid);
+}
+
+int main () {
+    test_PointerChase();
+}
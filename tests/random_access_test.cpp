@@ -0,0 +1,86 @@
+#include "simple_tester.hpp"
+
+#include "../src/random_access.hpp"
+
+// Checks that every offset of every thread falls inside a table of size bytes
+bool offsets_in_table ( const RandomAccessEngine &engine, uint_fast64_t size ) {
+    bool valid = true;
+    for ( unsigned t = 0; t < engine.threads(); ++t )
+        for ( uint_fast64_t offset : engine.offsets(t) )
+            valid = valid && offset < size / sizeof(uint64_t);
+    return valid;
+}
+
+void test_RandomAccessOffsets (  ) {
+    DESCRIBE("Random Access Offsets");
+
+    WHEN("I prepare a 64 KiB table with uniformly random offsets");
+    RandomAccessEngine uniform(2, vector<int>(), UNIFORMLY_RANDOM, 1000, 42);
+    uniform.prepare(64ul * 1024ul);
+    IFTHEN("I check the offsets of each thread", "there should be 1000");
+    isEqual(uniform.offsets(0).size(), (size_t) 1000);
+    isEqual(uniform.offsets(1).size(), (size_t) 1000);
+    IFTHEN("I check the offsets", "they should all be inside the table");
+    isTrue(offsets_in_table(uniform, 64ul * 1024ul));
+    IFTHEN("I compare the offsets of both threads", "they should be different");
+    isTrue(uniform.offsets(0) != uniform.offsets(1));
+
+    WHEN("I prepare the same table with the same seed");
+    RandomAccessEngine repeated(2, vector<int>(), UNIFORMLY_RANDOM, 1000, 42);
+    repeated.prepare(64ul * 1024ul);
+    IFTHEN("I compare the offsets", "they should be the same");
+    isTrue(uniform.offsets(0) == repeated.offsets(0));
+
+    WHEN("I prepare a 1 MiB table with exponentially random offsets");
+    RandomAccessEngine skewed(1, vector<int>(), EXPONENTIALLY_RANDOM, 4096, 7);
+    skewed.prepare(1ul << 20);
+    IFTHEN("I check the offsets", "they should all be inside the table");
+    isTrue(offsets_in_table(skewed, 1ul << 20));
+    IFTHEN("I count offsets in the first 1/16 of the table", "more than half should be there");
+    uint_fast64_t first = 0;
+    for ( uint_fast64_t offset : skewed.offsets(0) )
+        first += offset < ( 1ul << 20 ) / 16 / sizeof(uint64_t);
+    isGreater(first, (uint_fast64_t) 2048);
+}
+
+void test_RandomAccessEngine (  ) {
+    DESCRIBE("Random Access Engine");
+
+    WHEN("I create an engine with 2 threads");
+    RandomAccessEngine engine(2, vector<int>(), UNIFORMLY_RANDOM, 1ul << 16);
+    engine.prepare(1ul << 20);
+    IFTHEN("I measure random updates", "the rate should be positive");
+    isGreater(engine.measure(RANDOM_UPDATE), 0.0);
+
+    WHEN("I sweep an Exponential Distribution from 4 KiB to 1 MiB with 4 points");
+    IFTHEN("I measure random reads and writes", "I should get 8 results");
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            4096, 1024*1024, EXPONENTIALLY_SPACED, 4);
+    vector<RandomAccessPoint> points = engine.sweep(generator,
+            {RANDOM_READ, RANDOM_WRITE});
+    delete generator;
+    isEqual(points.size(), (size_t) 8);
+    IFTHEN("I check the results", "they should have positive rates and 2 threads");
+    bool valid = true;
+    for ( RandomAccessPoint &point : points )
+        valid = valid && point.mops > 0.0 && point.ns_per_access > 0.0 &&
+            point.threads == 2u && point.pattern == UNIFORMLY_RANDOM;
+    isTrue(valid);
+
+    WHEN("I attach a 1 MiB arena to an engine");
+    BufferArena arena(1ul << 20, SMALL_PAGES);
+    RandomAccessEngine attached(1, vector<int>(), UNIFORMLY_RANDOM, 1ul << 12);
+    attached.attach(arena);
+    IFTHEN("I measure a 512 KiB table", "the rate should be positive");
+    attached.prepare(1ul << 19);
+    isGreater(attached.measure(RANDOM_READ), 0.0);
+    IFTHEN("I prepare a table larger than the arena", "it should throw length_error");
+    bool thrown = false;
+    try { attached.prepare(1ul << 21); } catch ( length_error & ) { thrown = true; }
+    isTrue(thrown);
+}
+
+int main () {
+    test_RandomAccessOffsets();
+    test_RandomAccessEngine();
+}
@@ -0,0 +1,55 @@
+#include "simple_tester.hpp"
+
+#include "../src/random_engine.hpp"
+
+void test_Xoshiro256StarStar (  ) {
+    DESCRIBE("Xoshiro256** Engine");
+
+    WHEN("I create two engines with the same seed");
+    IFTHEN("I draw 1000 numbers from each", "they should be the same");
+    Xoshiro256StarStar first(42), second(42);
+    bool same = true;
+    for ( int i = 0; i < 1000; ++i ) same = same && first() == second();
+    isTrue(same);
+
+    WHEN("I create two engines with different seeds");
+    IFTHEN("I draw 1000 numbers from each", "they should differ");
+    Xoshiro256StarStar third(1), fourth(2);
+    bool different = false;
+    for ( int i = 0; i < 1000; ++i ) different = different || third() != fourth();
+    isTrue(different);
+
+    WHEN("I use an engine with a uniform distribution from 10 to 20");
+    IFTHEN("I draw 10000 numbers", "they should cover all values and stay inside the interval");
+    std::uniform_int_distribution<uint_fast64_t> randomize(10, 20);
+    bool seen[11] = { false };
+    bool inside_interval = true;
+    for ( int i = 0; i < 10000; ++i ) {
+        uint_fast64_t point = randomize(first);
+        inside_interval = inside_interval && point >= 10 && point <= 20;
+        if ( inside_interval ) seen[point - 10] = true;
+    }
+    bool covered = true;
+    for ( bool value : seen ) covered = covered && value;
+    isTrue(inside_interval && covered);
+}
+
+void test_DeviceEngine (  ) {
+    DESCRIBE("Device Engine");
+
+    WHEN("I use the device engine with a uniform distribution from 10 to 20");
+    IFTHEN("I draw 100 numbers", "they should stay inside the interval");
+    DeviceEngine device;
+    std::uniform_int_distribution<uint_fast64_t> randomize(10, 20);
+    bool inside_interval = true;
+    for ( int i = 0; i < 100; ++i ) {
+        uint_fast64_t point = randomize(device);
+        inside_interval = inside_interval && point >= 10 && point <= 20;
+    }
+    isTrue(inside_interval);
+}
+
+int main () {
+    test_Xoshiro256StarStar();
+    test_DeviceEngine();
+}
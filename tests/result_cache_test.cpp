@@ -0,0 +1,109 @@
+#include "simple_tester.hpp"
+
+#include <cstdio>
+
+#include "../src/result_cache.hpp"
+
+// Returns the key of a latency point of a sweep from 4 KiB to 1 MiB
+CacheKey latency_key ( uint_fast64_t size ) {
+    CacheKey key;
+    key.kernel = "latency";
+    key.generator = EXPONENTIALLY_SPACED;
+    key.min = 4096;
+    key.max = 1ul << 20;
+    key.count_limit = 8;
+    key.size = size;
+    return key;
+}
+
+// Returns one record of a measured size
+vector<ResultRecord> measured ( uint_fast64_t size, double value ) {
+    ResultRecord record;
+    record.generator = EXPONENTIALLY_SPACED;
+    record.size = size;
+    record.metric = "latency_ns";
+    record.value = value;
+    return { record };
+}
+
+void test_ResultCache (  ) {
+    const string path = "/tmp/topoperf_result_cache_test.cache";
+    remove(path.c_str());
+
+    DESCRIBE("Result Cache");
+
+    WHEN("I fetch 4 sizes from an empty cache");
+    IFTHEN("I count the measurements", "every size should be measured");
+    uint_fast64_t measurements = 0;
+    {
+        ResultCache cache(path, "host_a");
+        for ( uint_fast64_t size = 4096; size <= 32768; size *= 2 )
+            cache.fetch(latency_key(size), [&] (  ) {
+                    ++measurements;
+                    return measured(size, 1.5); });
+        isEqual(measurements, (uint_fast64_t) 4);
+    }
+
+    WHEN("I open the cache again and fetch 6 sizes");
+    ResultCache cache(path, "host_a");
+    measurements = 0;
+    vector<ResultRecord> records;
+    for ( uint_fast64_t size = 4096; size <= 131072; size *= 2 )
+        records = cache.fetch(latency_key(size), [&] (  ) {
+                ++measurements;
+                return measured(size, 2.5); });
+    IFTHEN("I count the measurements", "only the 2 missing sizes should be measured");
+    isEqual(measurements, (uint_fast64_t) 2);
+    IFTHEN("I count the hits", "the 4 stored sizes should be found");
+    isEqual(cache.hits(), (uint_fast64_t) 4);
+    IFTHEN("I look up a stored size", "its record should be the stored one");
+    bool found = cache.find(latency_key(8192), records);
+    isTrue(found && records.size() == 1 && records[0].value == 1.5 &&
+            records[0].metric == "latency_ns");
+
+    WHEN("I change the placement of a key");
+    IFTHEN("I look it up", "it should not be found");
+    CacheKey placed = latency_key(8192);
+    placed.cpu = 3;
+    isFalse(cache.find(placed, records));
+
+    WHEN("I open the same file for another host");
+    IFTHEN("I look up a stored size", "it should not be found");
+    ResultCache other(path, "host_b");
+    isFalse(other.find(latency_key(8192), records));
+
+    WHEN("I invalidate the latency points and open the file again");
+    IFTHEN("I check the number of removed points", "it should be 6");
+    isEqual(cache.invalidate("latency"), (uint_fast64_t) 6);
+    ResultCache reopened(path, "host_a");
+    IFTHEN("I check the number of points", "it should be 0");
+    isEqual(reopened.size(), (uint_fast64_t) 0);
+
+    WHEN("I store a point and the file ends with a truncated line");
+    reopened.store(latency_key(4096), measured(4096, 3.5));
+    {
+        ofstream file(path, ios::app);
+        file << "host_a,latency,exponentially_spaced,4096";
+    }
+    ResultCache recovered(path, "host_a");
+    IFTHEN("I check the number of points", "only the complete one should be loaded");
+    isEqual(recovered.size(), (uint_fast64_t) 1);
+
+    WHEN("I use a cache without a file");
+    ResultCache disabled("", "host_a");
+    measurements = 0;
+    for ( int i = 0; i < 2; ++i )
+        disabled.fetch(latency_key(4096), [&] (  ) {
+                ++measurements;
+                return measured(4096, 1.0); });
+    IFTHEN("I fetch the same point twice", "it should be measured twice");
+    isEqual(measurements, (uint_fast64_t) 2);
+
+    IFTHEN("I compute the host fingerprint twice", "it should be the same 16 digits");
+    isTrue(host_fingerprint() == host_fingerprint() && host_fingerprint().size() == 16);
+    remove(path.c_str());
+}
+
+int main () {
+    test_ResultCache();
+}
@@ -0,0 +1,93 @@
+#include "simple_tester.hpp"
+
+#include "../src/result_sink.hpp"
+
+// Creates 100 records of latency and bandwidth for sizes 64, 128, ...
+vector<ResultRecord> sample_records (  ) {
+    vector<ResultRecord> records;
+    for ( uint_fast64_t i = 1; i <= 50; ++i ) {
+        ResultRecord record;
+        record.generator = EXPONENTIALLY_SPACED;
+        record.size = 64 * i;
+        record.cpu = 1;
+        record.node = 0;
+        record.threads = 8;
+        record.metric = "latency_ns";
+        record.page_size = 4096;
+        record.value = 1.0 / 3.0 * i;
+        record.min = 0.5;
+        record.median = 1.5;
+        record.p99 = 9.25;
+        record.ci95 = 0.01;
+        record.samples = 7;
+        records.push_back(record);
+        record.metric = "read_gbs";
+        record.value = 100.0 + i;
+        records.push_back(record);
+    }
+    return records;
+}
+
+// Writes records in a format, loads them back and compares them
+bool round_trip ( ResultFormat format ) {
+    string path = "/tmp/topoperf_result_sink_test." + format_name(format);
+    vector<ResultRecord> records = sample_records();
+    {
+        ResultSink sink(path, format, 16);
+        for ( const ResultRecord &record : records ) sink.write(record);
+    }
+    vector<ResultRecord> loaded = load_results(path);
+    bool same = loaded.size() == records.size();
+    for ( size_t i = 0; same && i < records.size(); ++i )
+        same = loaded[i].generator == records[i].generator &&
+            loaded[i].size == records[i].size && loaded[i].cpu == records[i].cpu &&
+            loaded[i].node == records[i].node &&
+            loaded[i].threads == records[i].threads && loaded[i].metric == records[i].metric &&
+            loaded[i].page_size == records[i].page_size &&
+            loaded[i].value == records[i].value && loaded[i].p99 == records[i].p99 &&
+            loaded[i].samples == records[i].samples;
+    return same;
+}
+
+void test_ResultSink (  ) {
+    DESCRIBE("Result Sink");
+
+    WHEN("I write 100 records and load them back");
+    IFTHEN("I use CSV", "they should be the same");
+    isTrue(round_trip(CSV));
+    IFTHEN("I use JSON Lines", "they should be the same");
+    isTrue(round_trip(JSON_LINES));
+    IFTHEN("I use the binary format", "they should be the same");
+    isTrue(round_trip(BINARY));
+
+    WHEN("I flush a sink with a large batch");
+    string path = "/tmp/topoperf_result_sink_flush.csv";
+    ResultSink sink(path, CSV, 1000);
+    sink.write(sample_records()[0]);
+    sink.flush();
+    IFTHEN("I load the file before closing", "it should have the record");
+    isEqual(load_results(path).size(), (size_t) 1);
+}
+
+void test_diff_results (  ) {
+    DESCRIBE("Result Diff");
+
+    WHEN("I compare records with the same records 10% slower for latency");
+    vector<ResultRecord> before = sample_records();
+    vector<ResultRecord> after = sample_records();
+    for ( ResultRecord &record : after )
+        if ( record.metric == "latency_ns" ) record.value *= 1.1;
+    after.pop_back();
+    vector<ResultDiff> diffs = diff_results(before, after);
+    IFTHEN("I count the matches", "there should be 99");
+    isEqual(diffs.size(), (size_t) 99);
+    IFTHEN("I check the first difference", "it should be a latency change of 10%");
+    isTrue(diffs[0].after.metric == "latency_ns" && fabs(diffs[0].change - 0.1) < 1e-9);
+    IFTHEN("I check the last difference", "it should be a bandwidth without change");
+    isTrue(diffs.back().after.metric == "read_gbs" && diffs.back().change == 0.0);
+}
+
+int main () {
+    test_ResultSink();
+    test_diff_results();
+}
@@ -0,0 +1,100 @@
+#include "simple_tester.hpp"
+
+#include "../src/static_generators.hpp"
+
+// Checks that a compile-time sequence has the points of the runtime generator
+template <typename Sequence>
+bool matches_runtime ( Generators kind, uint_fast64_t min, uint_fast64_t max,
+        uint_fast64_t count ) {
+    DistributionGenerator *generator = DistributionGenerator::make_generator(min, max, kind, count);
+    vector<uint_fast64_t> runtime;
+    while ( ! generator->is_done() ) runtime.push_back(generator->next());
+    delete generator;
+    return runtime == Sequence::to_vector();
+}
+
+// Counts the points of runtime generators of 1 to counts points between
+// 4 KiB and max that differ from spaced_point
+uint_fast64_t runtime_mismatches ( Generators kind, uint_fast64_t max,
+        uint_fast64_t counts ) {
+    uint_fast64_t mismatches = 0;
+    for ( uint_fast64_t count = 1; count <= counts; ++count ) {
+        DistributionGenerator *generator = DistributionGenerator::make_generator(
+                4096, max, kind, count);
+        for ( uint_fast64_t index = 0; ! generator->is_done(); ++index )
+            mismatches += generator->next() != spaced_point(kind, 4096, max, count, index);
+        delete generator;
+    }
+    return mismatches;
+}
+
+void test_constexpr_math (  ) {
+    DESCRIBE("Compile-time Math");
+
+    WHEN("I compute logarithms and exponentials at compile time");
+    constexpr double log_1000 = series_log(1000.0);
+    constexpr double exp_10 = series_exp(10.0);
+    IFTHEN("I compare log(1000) with std::log", "it should be within 1e-14");
+    isTrue(fabs(log_1000 - log(1000.0)) < 1e-14);
+    IFTHEN("I compare exp(10) with std::exp", "it should be within 1e-14 in relative terms");
+    isTrue(fabs(exp_10 - exp(10.0)) / exp(10.0) < 1e-14);
+    IFTHEN("I compare log(2^40) with std::log", "it should be within 1e-13");
+    isTrue(fabs(series_log(1099511627776.0) - log(1099511627776.0)) < 1e-13);
+}
+
+void test_SpacedSequence (  ) {
+    DESCRIBE("Spaced Sequence");
+
+    WHEN("I create an Exponential Sequence from 2 to 2048 with 9 points");
+    typedef SpacedSequence<EXPONENTIALLY_SPACED, 2, 2048, 9> Powers;
+    static_assert(Powers::points[0] == 4, "computed at compile time");
+    IFTHEN("I check its points", "they should be 4, 8, ..., 1024");
+    isTrue(Powers::size == 9 && Powers::points[0] == 4 && Powers::points[8] == 1024);
+
+    WHEN("I compare compile-time sequences with runtime generators");
+    IFTHEN("I check an Average Point from 1000 to 0", "they should be the same");
+    isTrue(matches_runtime<SpacedSequence<AVERAGE_POINT, 1000, 0>>(AVERAGE_POINT, 1000, 0, 1));
+    IFTHEN("I check a Uniform Sequence from 0 to 100 with 9 points", "they should be the same");
+    isTrue(matches_runtime<SpacedSequence<UNIFORMLY_SPACED, 0, 100, 9>>(UNIFORMLY_SPACED, 0, 100, 9));
+    IFTHEN("I check an Exponential Sequence from 4 KiB to 1 GiB with 64 points", "they should be the same");
+    isTrue(matches_runtime<SpacedSequence<EXPONENTIALLY_SPACED, 4096, 1ul << 30, 64>>(
+                EXPONENTIALLY_SPACED, 4096, 1ul << 30, 64));
+    IFTHEN("I check an Exponential Sequence from 0 to 100 with 4 points", "they should be the same");
+    isTrue(matches_runtime<SpacedSequence<EXPONENTIALLY_SPACED, 0, 100, 4>>(EXPONENTIALLY_SPACED, 0, 100, 4));
+    IFTHEN("I check a Mid Point from 2 to 32", "they should be the same");
+    isTrue(matches_runtime<SpacedSequence<MID_POINT, 2, 32>>(MID_POINT, 2, 32, 1));
+    IFTHEN("I check Exponential Sequences from 4 KiB to 2^46, 2^50 and 2^53", "they should be the same");
+    isTrue(matches_runtime<SpacedSequence<EXPONENTIALLY_SPACED, 4096, 1ul << 46, 400>>(
+                EXPONENTIALLY_SPACED, 4096, 1ul << 46, 400) &&
+            matches_runtime<SpacedSequence<EXPONENTIALLY_SPACED, 4096, 1ul << 50, 400>>(
+                EXPONENTIALLY_SPACED, 4096, 1ul << 50, 400) &&
+            matches_runtime<SpacedSequence<EXPONENTIALLY_SPACED, 4096, 1ul << 53, 400>>(
+                EXPONENTIALLY_SPACED, 4096, 1ul << 53, 400));
+    IFTHEN("I check sequences from 4 KiB to 2^60 and to 2^64 - 1", "they should be the same");
+    isTrue(matches_runtime<SpacedSequence<EXPONENTIALLY_SPACED, 4096, 1ul << 60, 40>>(
+                EXPONENTIALLY_SPACED, 4096, 1ul << 60, 40) &&
+            matches_runtime<SpacedSequence<EXPONENTIALLY_SPACED, 4096, UINT64_MAX, 400>>(
+                EXPONENTIALLY_SPACED, 4096, UINT64_MAX, 400) &&
+            matches_runtime<SpacedSequence<MID_POINT, 4096, 1ul << 60>>(
+                MID_POINT, 4096, 1ul << 60, 1));
+    IFTHEN("I check runtime generators of 1 to 200 points up to 2^53", "they should use the same formula");
+    isEqual(runtime_mismatches(EXPONENTIALLY_SPACED, 1ul << 46, 200) +
+            runtime_mismatches(EXPONENTIALLY_SPACED, 1ul << 50, 200) +
+            runtime_mismatches(EXPONENTIALLY_SPACED, 1ul << 53, 200) +
+            runtime_mismatches(MID_POINT, 1ul << 53, 1), (uint_fast64_t) 0);
+    IFTHEN("I check runtime generators of 1 to 200 points up to 2^60 and 2^64 - 1", "they should use the same formula");
+    isEqual(runtime_mismatches(EXPONENTIALLY_SPACED, 1ul << 60, 200) +
+            runtime_mismatches(EXPONENTIALLY_SPACED, UINT64_MAX, 200) +
+            runtime_mismatches(MID_POINT, UINT64_MAX, 1), (uint_fast64_t) 0);
+
+    WHEN("I iterate over a Uniform Sequence from 0 to 10 with 4 points");
+    IFTHEN("I sum its points", "the result should be 2 + 4 + 6 + 8");
+    uint_fast64_t sum = 0;
+    for ( uint_fast64_t point : SpacedSequence<UNIFORMLY_SPACED, 0, 10, 4>() ) sum += point;
+    isEqual(sum, (uint_fast64_t) 20);
+}
+
+int main () {
+    test_constexpr_math();
+    test_SpacedSequence();
+}
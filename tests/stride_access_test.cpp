@@ -0,0 +1,44 @@
+#include "simple_tester.hpp"
+
+#include "../src/stride_access.hpp"
+
+void test_StrideAccess (  ) {
+    DESCRIBE("Stride Access");
+
+    StrideAccess access(1ul << 20, 1ul << 14, 42);
+
+    WHEN("I measure a 64 B stride in increasing order");
+    StridePoint forward = access.measure(64, FORWARD);
+    IFTHEN("I check the result", "latency, throughput and bandwidth should be positive");
+    isTrue(forward.stride == 64 && forward.ns_per_load > 0.0 &&
+            forward.ns_per_access > 0.0 && forward.gb_per_s > 0.0);
+
+    WHEN("I measure a 100 B stride in random order");
+    StridePoint shuffled = access.measure(100, SHUFFLED);
+    IFTHEN("I check the stride", "it should be rounded down to 96 B");
+    isEqual(shuffled.stride, (uint_fast64_t) 96);
+    IFTHEN("I check the order", "it should be shuffled");
+    isTrue(shuffled.order == SHUFFLED && shuffled.ns_per_load > 0.0);
+
+    WHEN("I measure a stride larger than the buffer");
+    IFTHEN("I check the stride", "it should be half of the buffer");
+    isEqual(access.measure(4ul << 20, SHUFFLED).stride, (uint_fast64_t) 1ul << 19);
+
+    WHEN("I sweep an Exponential Distribution of strides from 8 B to 16 KiB with 6 points");
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            8, 16*1024, EXPONENTIALLY_SPACED, 6);
+    vector<StridePoint> points = access.sweep(generator);
+    delete generator;
+    IFTHEN("I count the results", "there should be 2 orders for each stride");
+    isEqual(points.size(), (size_t) 12);
+    IFTHEN("I check the results", "strides should be whole words in both orders");
+    bool valid = true;
+    for ( uint_fast64_t i = 0; i < points.size(); ++i )
+        valid = valid && points[i].stride % 8 == 0 && points[i].ns_per_load > 0.0 &&
+            points[i].order == ( i % 2 ? SHUFFLED : FORWARD );
+    isTrue(valid);
+}
+
+int main () {
+    test_StrideAccess();
+}
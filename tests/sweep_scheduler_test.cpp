@@ -0,0 +1,106 @@
+#include "simple_tester.hpp"
+#include "fake_sysfs.hpp"
+
+#include "../src/sweep_scheduler.hpp"
+
+// Returns true if two runs of the same domain overlap in time
+bool domains_overlap ( const vector<ScheduledRun> &runs ) {
+    for ( const ScheduledRun &a : runs )
+        for ( const ScheduledRun &b : runs )
+            if ( &a != &b && a.domain == b.domain && a.begin < b.end &&
+                    b.begin < a.end )
+                return true;
+    return false;
+}
+
+void test_SweepScheduler (  ) {
+    DESCRIBE("Sweep Scheduler");
+
+    // Measurements sleep, so domains run in parallel even on a single CPU
+    auto sleeping = [] ( const Placement &, uint_fast64_t, bool ) {
+        this_thread::sleep_for(chrono::milliseconds(20));
+    };
+
+    WHEN("I schedule 4 sizes on CPU 0 and 4 sizes on CPU 2 of 2 packages");
+    Topology topology = Topology::discover(fake_sysfs("/tmp/topoperf_scheduler_test"));
+    SweepScheduler scheduler(topology, PACKAGE_DOMAIN);
+    scheduler.add({ 1, 2, 3, 4 }, { 0, 0 }, sleeping);
+    scheduler.add(DistributionGenerator::make_generator(4096, 1ul << 20,
+                EXPONENTIALLY_SPACED, 4), { 2, 1 }, sleeping);
+    auto begin = chrono::steady_clock::now();
+    vector<ScheduledRun> runs = scheduler.run();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    IFTHEN("I count the domains and the runs", "there should be 2 domains and 8 runs");
+    isTrue(scheduler.domains() == 2u && runs.size() == 8);
+    IFTHEN("I check the runs of each domain", "they should not overlap");
+    isTrue(! domains_overlap(runs));
+    IFTHEN("I check the wall time", "it should be less than running them serially");
+    isLess(elapsed, 8 * 0.020);
+    IFTHEN("I check the domain of each run", "it should be the domain of its CPU");
+    bool domains = true;
+    for ( ScheduledRun &run : runs )
+        domains = domains && run.domain == ( run.placement.cpu == 0 ? 0u : 1u ) &&
+            ! run.stolen;
+    isTrue(domains);
+
+    WHEN("I schedule 6 sizes that can run anywhere, over 2 LLC domains");
+    SweepScheduler anywhere(topology, LLC_DOMAIN);
+    anywhere.add({ 1, 2, 3, 4, 5, 6 }, { -1, -1 }, sleeping);
+    runs = anywhere.run();
+    IFTHEN("I count the runs", "every size should run once");
+    uint_fast64_t sum = 0;
+    for ( ScheduledRun &run : runs ) sum += run.size;
+    isTrue(runs.size() == 6 && sum == 21);
+    IFTHEN("I check the placements", "they should use the first CPU and node of their domain");
+    bool placements = true;
+    for ( ScheduledRun &run : runs )
+        placements = placements && run.placement.cpu == 2 * (int) run.domain &&
+            run.placement.node == (int) run.domain;
+    isTrue(placements && ! domains_overlap(runs));
+
+    WHEN("I schedule 4 placed sizes and 4 sizes that can run anywhere on the same domain");
+    SweepScheduler stealing(topology, PACKAGE_DOMAIN);
+    stealing.add({ 1, 2, 3, 4 }, { 0, 0 }, sleeping);
+    stealing.add({ 5, 6, 7, 8 }, { -1, -1 }, sleeping);
+    runs = stealing.run();
+    IFTHEN("I count the runs of the second domain", "it should have stolen some of them");
+    uint_fast64_t stolen = 0;
+    for ( ScheduledRun &run : runs ) stolen += run.stolen;
+    isTrue(runs.size() == 8 && stolen > 0 && ! domains_overlap(runs));
+
+    WHEN("I schedule a remote placement next to a local one on the node of its memory");
+    SweepScheduler remote(topology, PACKAGE_DOMAIN);
+    remote.add({ 1, 2 }, { 0, 1 }, sleeping);
+    remote.add({ 3, 4 }, { 2, 1 }, sleeping);
+    runs = remote.run();
+    IFTHEN("I check the runs", "they should not overlap, as they load the same node");
+    bool overlap = false;
+    for ( const ScheduledRun &a : runs )
+        for ( const ScheduledRun &b : runs )
+            overlap = overlap || ( &a != &b && a.begin < b.end && b.begin < a.end );
+    isTrue(runs.size() == 4 && ! overlap);
+
+    WHEN("I schedule a size on a CPU that does not exist");
+    SweepScheduler missing(topology);
+    bool reported = true;
+    missing.add({ 1 }, { 1000, 0 }, [&] ( const Placement &, uint_fast64_t, bool placed ) {
+        reported = placed;
+    });
+    runs = missing.run();
+    IFTHEN("I check the placement given to the measurement", "it should not be placed");
+    isTrue(! reported && runs.size() == 1 && ! runs[0].placed);
+
+    WHEN("A measurement throws an exception");
+    SweepScheduler failing(topology);
+    failing.add({ 1 }, { 0, 0 }, [] ( const Placement &, uint_fast64_t, bool ) {
+        throw runtime_error("failed");
+    });
+    IFTHEN("I run the scheduler", "it should rethrow the exception");
+    bool thrown = false;
+    try { failing.run(); } catch ( runtime_error & ) { thrown = true; }
+    isTrue(thrown);
+}
+
+int main () {
+    test_SweepScheduler();
+}
@@ -0,0 +1,76 @@
+#include "simple_tester.hpp"
+
+#include "../src/timing.hpp"
+#include "../src/pointer_chase.hpp"
+
+void test_compute_stats (  ) {
+    DESCRIBE("Timing Statistics");
+
+    WHEN("I compute statistics of 1, 2, ..., 10 and an outlier of 1000");
+    vector<double> samples;
+    for ( int i = 1; i <= 10; ++i ) samples.push_back(i);
+    samples.push_back(1000.0);
+    TimingStats stats = compute_stats(samples, 5.0);
+    IFTHEN("I check the minimum and the median", "they should be 1 and 6");
+    isTrue(stats.min == 1.0 && stats.median == 6.0);
+    IFTHEN("I check the 99th percentile", "it should be the outlier");
+    isEqual(stats.p99, 1000.0);
+    IFTHEN("I check the rejected samples", "only the outlier should be rejected");
+    isEqual(stats.rejected, (uint_fast64_t) 1);
+    IFTHEN("I check the mean", "it should ignore the outlier");
+    isEqual(stats.mean, 5.5);
+    IFTHEN("I check the confidence interval", "it should be positive");
+    isGreater(stats.ci95, 0.0);
+
+    WHEN("I compute statistics of identical samples");
+    stats = compute_stats(vector<double>(10, 3.0), 5.0);
+    IFTHEN("I check the confidence interval", "it should be zero, with nothing rejected");
+    isTrue(stats.ci95 == 0.0 && stats.rejected == 0 && stats.mean == 3.0);
+}
+
+void test_Timer (  ) {
+    DESCRIBE("Timer");
+
+    WHEN("I time 10 ms of CLOCK_MONOTONIC_RAW with the default timer");
+    Timer timer;
+    uint_fast64_t begin = timer.now();
+    uint_fast64_t start = monotonic_raw_ns();
+    while ( monotonic_raw_ns() - start < 10000000ul ) {  }
+    double elapsed = timer.to_ns(timer.now() - begin);
+    IFTHEN("I check the elapsed time", "it should be within 10% of 10 ms");
+    isWithin(elapsed, 9.0e6, 11.0e6);
+
+    WHEN("I create a timer on CLOCK_MONOTONIC_RAW");
+    IFTHEN("I check its frequency", "it should count ns");
+    isEqual(Timer(MONOTONIC_RAW).ticks_per_ns(), 1.0);
+}
+
+void test_MeasurementHarness (  ) {
+    DESCRIBE("Measurement Harness");
+
+    WHEN("I measure a pointer chase with at most 20 repetitions");
+    MeasurementHarness harness(1, 5, 20, 0.01);
+    PointerChase chase(64ul, 1ul << 12);
+    chase.prepare(16ul * 1024ul);
+    TimingStats stats = harness.run([&] (  ) { chase.traverse(); }, chase.loads());
+    IFTHEN("I count the samples", "there should be between 5 and 20");
+    isWithin(stats.samples, (uint_fast64_t) 5, (uint_fast64_t) 20);
+    IFTHEN("I check the latency", "the minimum should be positive and below the p99");
+    isTrue(stats.min > 0.0 && stats.min <= stats.p99);
+
+    WHEN("I sweep an Exponential Distribution from 4 KiB to 64 KiB with 3 points");
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            4096, 64*1024, EXPONENTIALLY_SPACED, 3);
+    vector<TimedPoint> points = harness.sweep(generator,
+            [&] ( uint_fast64_t size ) { chase.prepare(size); },
+            [&] ( uint_fast64_t ) { chase.traverse(); },
+            [&] ( uint_fast64_t ) { return (double) chase.loads(); });
+    IFTHEN("I count the results", "there should be 3");
+    isEqual(points.size(), (size_t) 3);
+}
+
+int main () {
+    test_compute_stats();
+    test_Timer();
+    test_MeasurementHarness();
+}
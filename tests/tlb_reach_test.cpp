@@ -0,0 +1,45 @@
+#include "simple_tester.hpp"
+
+#include "../src/tlb_reach.hpp"
+
+void test_TlbReach (  ) {
+    DESCRIBE("TLB Reach");
+
+    TlbReach small(SMALL_PAGES, 1ul << 16, 42);
+
+    WHEN("I measure one line in each of 64 small pages");
+    TlbPoint point = small.measure(64);
+    IFTHEN("I check the result", "both chains should take time");
+    isTrue(point.pages == 64 && point.ns_per_load > 0.0 && point.ns_control > 0.0);
+    IFTHEN("I check the page size", "it should be the page size of the system");
+    isEqual(point.page_size, (uint_fast64_t) sysconf(_SC_PAGESIZE));
+    IFTHEN("I check the walk cost", "it should be the difference of both chains");
+    isTrue(point.ns_per_walk == point.ns_per_load - point.ns_control);
+
+    WHEN("I sweep an Exponential Distribution of 16 to 4096 small pages with 5 points");
+    DistributionGenerator *generator = DistributionGenerator::make_generator(
+            16, 4096, EXPONENTIALLY_SPACED, 5);
+    vector<TlbPoint> points = small.sweep(generator);
+    delete generator;
+    IFTHEN("I count the results", "there should be 5");
+    isEqual(points.size(), (size_t) 5);
+    IFTHEN("I check the results", "pages should grow and every load should take time");
+    bool valid = true;
+    for ( uint_fast64_t i = 0; i < points.size(); ++i )
+        valid = valid && points[i].ns_per_load > 0.0 &&
+            ( i == 0 || points[i].pages > points[i - 1].pages );
+    isTrue(valid);
+
+    WHEN("I measure one line in each of 8 huge pages");
+    TlbReach huge(HUGE_2M, 1ul << 16, 42);
+    point = huge.measure(8);
+    IFTHEN("I check the buffer", "it should hold 8 pages of the size obtained");
+    isTrue(point.pages == 8 && point.page_size >= (uint_fast64_t) sysconf(_SC_PAGESIZE) &&
+            huge.page_size() == point.page_size && point.ns_per_load > 0.0);
+    IFTHEN("I check the size of the buffer", "it should be 8 pages of the size obtained, even after a fallback");
+    isEqual(huge.size(), 8 * point.page_size);
+}
+
+int main () {
+    test_TlbReach();
+}
@@ -0,0 +1,69 @@
+#include "simple_tester.hpp"
+#include "fake_sysfs.hpp"
+
+#include "../src/topology.hpp"
+
+void test_parse_cpu_list (  ) {
+    DESCRIBE("CPU List Parsing");
+
+    WHEN("I parse the list 0-3,8,10-11");
+    IFTHEN("I count the CPUs", "there should be 7");
+    vector<int> cpus = parse_cpu_list("0-3,8,10-11");
+    isEqual(cpus.size(), (size_t) 7);
+    IFTHEN("I check the last CPU", "it should be 11");
+    isEqual(cpus.back(), 11);
+
+    WHEN("I parse an empty list");
+    IFTHEN("I count the CPUs", "there should be none");
+    isEqual(parse_cpu_list("").size(), (size_t) 0);
+}
+
+void test_Topology (  ) {
+    DESCRIBE("Topology");
+
+    WHEN("I discover a fake machine with 2 sockets and 2 nodes");
+    Topology topology = Topology::discover(fake_sysfs("/tmp/topoperf_topology_test"));
+    IFTHEN("I count CPUs and nodes", "there should be 4 CPUs");
+    isEqual(topology.cpus().size(), (size_t) 4);
+    IFTHEN("I count nodes", "there should be 2 nodes");
+    isEqual(topology.nodes().size(), (size_t) 2);
+    IFTHEN("I check the node of CPU 3", "it should be node 1");
+    isEqual(topology.node_of_cpu(3), 1);
+    IFTHEN("I count packages and LLC domains", "there should be 2 of each");
+    isTrue(topology.packages().size() == 2 && topology.llc_domains().size() == 2);
+    IFTHEN("I check the largest LLC", "it should be 32 MiB");
+    isEqual(topology.largest_llc(), (uint_fast64_t) 32ul << 20);
+    IFTHEN("I build the placement matrix", "it should have 2 x 2 placements");
+    vector<Placement> matrix = topology.placement_matrix();
+    isEqual(matrix.size(), (size_t) 4);
+    IFTHEN("I check the last placement", "it should run on CPU 2 with memory on node 1");
+    isTrue(matrix.back().cpu == 2 && matrix.back().node == 1);
+    IFTHEN("I build the matrix with every CPU", "it should have 4 x 2 placements");
+    isEqual(topology.placement_matrix(true).size(), (size_t) 8);
+
+    WHEN("I add a memory node without CPUs to the fake machine");
+    string root = fake_sysfs("/tmp/topoperf_topology_test");
+    write_file(root + "/node", "online", "0-2");
+    write_file(root + "/node/node2", "cpulist", "");
+    Topology expanded = Topology::discover(root);
+    IFTHEN("I count nodes", "there should be 3 nodes");
+    isEqual(expanded.nodes().size(), (size_t) 3);
+    IFTHEN("I build the placement matrix", "it should have 2 x 3 placements");
+    matrix = expanded.placement_matrix();
+    isTrue(matrix.size() == 6 && matrix.back().cpu == 2 && matrix.back().node == 2);
+
+    WHEN("I discover this machine");
+    Topology local = Topology::discover();
+    IFTHEN("I count CPUs and nodes", "there should be at least one of each");
+    isTrue(local.cpus().size() > 0 && local.nodes().size() > 0);
+    IFTHEN("I run a function on its first placement", "it should run on the requested CPU");
+    Placement placement = local.placement_matrix().front();
+    int cpu = -1;
+    bool placed = run_placed(placement, [&] (  ) { cpu = sched_getcpu(); });
+    isTrue(placed && cpu == placement.cpu);
+}
+
+int main () {
+    test_parse_cpu_list();
+    test_Topology();
+}